@@ -2,6 +2,8 @@
 #define _DEFINITION_H_
 #pragma once
 
+#include "sdkconfig.h"
+
 #ifndef MAX
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 #endif
@@ -20,4 +22,45 @@
 
 #define TASK_STACK_DEPTH        4096
 
+// task topology (Kconfig: Application Configuration > Task Topology)
+#if CONFIG_APP_TASK_PINNING
+#define TASK_SENSOR_CORE_ID     1       // APP CPU (PRO CPU: matter, wifi, ble, lwip)
+#else
+#define TASK_SENSOR_CORE_ID     tskNO_AFFINITY
+#endif
+
+#define PM_MAX_CPU_FREQ_MHZ     160
+#define PM_MIN_CPU_FREQ_MHZ     40
+#define PM_LIGHT_SLEEP_ENABLE   true
+
+#define STAT_WINDOW_COUNT       3
+#define STAT_WINDOW_SEC_LIST    {60, 3600, 86400}   // 1 minute, 1 hour, 1 day
+#define STAT_BUCKET_COUNT       60
+#define STAT_REPORT_PERIOD_US   10 * 1000 * 1000
+#define STAT_DEFAULT_HOLD_LIMIT_US  2 * SENSOR_DEFAULT_PERIOD_MS * 1000LL  // replaced by 2x the longest sample period
+
+#define HISTORY_PARTITION_LABEL     "history"
+#define HISTORY_PARTITION_SUBTYPE   0x40
+#define HISTORY_SAMPLE_PERIOD_US    10 * 1000 * 1000
+
+#define FLICKER_MAX_SAMPLES         128
+#define FLICKER_BIN_COUNT           4
+#define FLICKER_ANALYSIS_PERIOD_US  10 * 60 * 1000 * 1000LL
+#define FLICKER_BURST_PERIOD_US     32000   // 31.25 Hz, 25ms integration: 50/60/100 Hz alias to 12.5/2.5/6.25 Hz
+#define FLICKER_POLL_PERIOD_US      100 * 1000LL    // burst completion check of the measurement task
+
+#define LIGHT_SENSOR_ENDPOINT_ID    1       // kept whenever the sensor is (re)attached
+#define DISCOVERY_PERIOD_US         30 * 1000 * 1000LL
+#define DISCOVERY_MISSING_COUNT     2       // consecutive failed checks before the endpoint is removed
+
+#define SENSOR_DEFAULT_PERIOD_MS    1000
+#define SENSOR_MIN_PERIOD_MS        100
+#define SENSOR_MAX_PERIOD_MS        3600 * 1000
+#define SAMPLING_DEFAULT_MAX_PERIOD_MS  5 * 1000        // adaptive period upper bound (stable light)
+
+#define SAMPLE_QUEUE_LENGTH         16      // measurement task -> matter context (report_sample_t)
+
+#define TRACE_ENABLE                1       // 0: trace macros compile to nothing
+#define TRACE_BUFFER_SIZE           512     // events (ring buffer, oldest overwritten)
+
 #endif
\ No newline at end of file
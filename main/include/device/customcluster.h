@@ -0,0 +1,44 @@
+#pragma once
+#ifndef _CUSTOM_CLUSTER_H_
+#define _CUSTOM_CLUSTER_H_
+
+/*
+ * Manufacturer specific clusters (cluster id: 0xMMMM_FC00 ~ 0xMMMM_FFFE, MMMM = vendor id)
+ */
+#define MATTER_VENDOR_ID                            0xFFF2
+
+/* Illuminance Statistics (light sensor endpoint) */
+#define CLUSTER_ID_ILLUMINANCE_STATISTICS           0xFFF2FC00
+#define ATTR_ID_ILLUMSTAT_WINDOW_STRIDE             0x0010  // attribute id = window index * stride + offset
+#define ATTR_ID_ILLUMSTAT_WINDOW_DURATION           0x0000  // uint32, unit: second
+#define ATTR_ID_ILLUMSTAT_SAMPLE_COUNT              0x0001  // uint32
+#define ATTR_ID_ILLUMSTAT_MIN_VALUE                 0x0002  // float, unit: lux
+#define ATTR_ID_ILLUMSTAT_MAX_VALUE                 0x0003  // float, unit: lux
+#define ATTR_ID_ILLUMSTAT_MEAN_VALUE                0x0004  // float, unit: lux
+#define ATTR_ID_ILLUMSTAT_TIME_WEIGHTED_MEAN        0x0005  // float, unit: lux
+#define ATTR_ID_ILLUMSTAT_VARIANCE                  0x0006  // float, unit: lux^2
+#define ATTR_ID_ILLUMSTAT_INTEGRAL                  0x0007  // float, unit: lux * hour
+
+/* Light Quality (light sensor endpoint) */
+#define CLUSTER_ID_LIGHT_QUALITY                    0xFFF2FC01
+#define ATTR_ID_LIGHTQ_PERCENT_MODULATION           0x0000  // float, unit: percent
+#define ATTR_ID_LIGHTQ_FLICKER_INDEX                0x0001  // float, 0 ~ 1
+#define ATTR_ID_LIGHTQ_MAINS_FLICKER_FREQUENCY      0x0002  // uint16, unit: Hz (0: not detected)
+#define ATTR_ID_LIGHTQ_MAINS_FLICKER_MODULATION     0x0003  // float, unit: percent
+#define ATTR_ID_LIGHTQ_UNSUPPORTED_MAINS_BINS       0x0004  // bitmap8, bit0~3: 100/120/50/60 Hz not measurable
+#define ATTR_ID_LIGHTQ_LIGHT_SOURCE_CLASS           0x0010  // enum8 (eLightSourceClass)
+#define ATTR_ID_LIGHTQ_COLOR_TEMPERATURE            0x0011  // uint16, unit: kelvin (0: unknown)
+
+/* Runtime Metrics (root node endpoint) */
+#define CLUSTER_ID_RUNTIME_METRICS                  0xFFF2FC02
+#define ATTR_ID_METRICS_COUNTER_BASE                0x0000  // uint32, attribute id = base + eMetricCounter
+#define ATTR_ID_METRICS_GAUGE_BASE                  0x0040  // uint32, attribute id = base + eMetricGauge
+#define ATTR_ID_METRICS_HISTOGRAM_BASE              0x0080  // attribute id = base + eMetricHistogram * stride + offset
+#define ATTR_ID_METRICS_HISTOGRAM_STRIDE            0x0010
+#define ATTR_ID_METRICS_HISTOGRAM_BUCKET            0x0000  // uint32 array (offset 0x00 ~ 0x07, METRIC_HISTOGRAM_BUCKET_COUNT)
+#define ATTR_ID_METRICS_HISTOGRAM_COUNT             0x0008  // uint32
+#define ATTR_ID_METRICS_HISTOGRAM_SUM               0x0009  // uint64
+#define ATTR_ID_METRICS_HISTOGRAM_MAX               0x000A  // uint32
+#define CMD_ID_METRICS_RESET                        0x0000  // no arguments
+
+#endif
@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <esp_matter.h>
 #include <esp_matter_core.h>
+#include "statistics.h"
+#include "flicker.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +57,9 @@ protected:
 
 public:
     virtual void update_measured_value_illuminance(uint16_t value); // unit: lux
+    virtual void update_illuminance_statistics(const statistics_result_t *results, int count);
+    virtual void update_flicker_result(const flicker_result_t *result);
+    virtual void update_light_source(uint8_t source_class, uint16_t color_temperature);
 
 protected:
     uint16_t m_measured_value_illuminance;
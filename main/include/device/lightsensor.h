@@ -4,6 +4,9 @@
 
 #include "device.h"
 
+#define CCT_DEADBAND_K              50  // color temperature is reported when it moves by max(50 K, 3 %)
+#define CCT_DEADBAND_PERCENT        3
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -28,11 +31,25 @@ public:
     bool set_max_measured_value(uint16_t value); // unit: lux
 
     void update_measured_value_illuminance(uint16_t value) override; // unit: lux
+    void update_illuminance_statistics(const statistics_result_t *results, int count) override;
+    void update_flicker_result(const flicker_result_t *result) override;
+    void update_light_source(uint8_t source_class, uint16_t color_temperature) override;
 
 private:
     bool m_matter_update_by_client_clus_illummeas_attr_measureval;
-
+    bool m_matter_update_by_client_clus_illumstat_attr;
+    bool m_matter_update_by_client_clus_lightq_attr;
+    statistics_result_t m_illuminance_statistics[STAT_WINDOW_COUNT];
+    flicker_result_t m_flicker_result;
+    uint8_t m_light_source_class;       // reported values
+    uint16_t m_color_temperature;
+
+    bool matter_create_clus_illumstat();
+    bool matter_create_clus_lightq();
     void matter_update_clus_illummeas_attr_measureval(bool force_update = false);
+    void matter_update_clus_illumstat_attr_all(bool force_update = false);
+    void matter_update_clus_lightq_attr_flicker(bool force_update = false);
+    void matter_update_clus_lightq_attr_source(bool force_update = false);
 };
 
 #ifdef __cplusplus
@@ -4,11 +4,43 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+
+#define I2C_TRANSFER_TIMEOUT_MS     20      // per attempt (longest transfer at 400 kHz takes < 1 ms)
+#define I2C_RETRY_COUNT             2       // attempts after the first failure
+#define I2C_RETRY_BACKOFF_MS        2       // doubled per retry
+#define I2C_BREAKER_SLOT_COUNT      4       // tracked device addresses
+#define I2C_BREAKER_THRESHOLD       3       // consecutive failed transfers (after retries) to open the circuit
+#define I2C_BREAKER_OPEN_MS         5000    // doubled on every failed trial transfer
+#define I2C_BREAKER_OPEN_MAX_MS     300000
+#define I2C_PROBE_TIMEOUT_MS        5       // discovery probe (single attempt, no breaker)
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum
+{
+    I2CWrite = 0,
+    I2CRead,
+    I2CWriteRead,
+    I2CTransferTypeCount
+} eI2CTransferType;
+
+/**
+ * @brief per device circuit breaker
+ * closed -> (I2C_BREAKER_THRESHOLD consecutive failures) -> open: transfers are refused immediately
+ * -> (open period elapsed) -> half open: one trial transfer, success closes / failure reopens with doubled period
+ */
+typedef struct i2c_breaker {
+    uint8_t dev_addr;
+    uint8_t consecutive_failures;
+    uint32_t open_ms;           // current open period (0: closed)
+    int64_t open_until_us;
+} i2c_breaker_t;
+
 class CI2CMaster
 {
 public:
@@ -20,14 +52,38 @@ public:
     bool initialize(int port, int gpio_scl, int gpio_sda, uint32_t clk_speed);
     bool release();
 
-    bool write_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms = 1000);
-    bool read_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms = 1000);
-    bool write_and_read_bytes(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms = 1000);
+    bool write_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms = I2C_TRANSFER_TIMEOUT_MS);
+    bool read_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms = I2C_TRANSFER_TIMEOUT_MS);
+    bool write_and_read_bytes(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms = I2C_TRANSFER_TIMEOUT_MS);
+
+    // discovery: single attempt, bypasses retries and circuit breakers
+    bool probe(uint8_t dev_addr);
+    bool probe_read(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len);
+
+    bool recover_bus();
+    bool is_device_available(uint8_t dev_addr);     // false while the circuit is open
+    void reset_breakers();
+    void print_info();
 
 private:
     static CI2CMaster *_instance;
     int m_port;
+    int m_gpio_scl;
+    int m_gpio_sda;
+    uint32_t m_clk_speed;
     bool m_initialized;
+    SemaphoreHandle_t m_mutex;      // transfer attempts vs bus recovery (driver reinstall)
+    portMUX_TYPE m_spinlock;        // breaker state
+    i2c_breaker_t m_breakers[I2C_BREAKER_SLOT_COUNT];
+
+    bool install_driver();
+    bool clear_bus();
+    bool transfer(eI2CTransferType type, uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms);
+    esp_err_t transfer_once(eI2CTransferType type, uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms);
+    bool breaker_allow(uint8_t dev_addr);
+    void breaker_update(uint8_t dev_addr, bool success);
+    i2c_breaker_t* find_breaker(uint8_t dev_addr, bool allocate);
+    void update_metrics(bool success, int64_t start_us);
 };
 
 inline CI2CMaster* GetI2CMaster() {
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef _CALIBRATION_H_
+#define _CALIBRATION_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#define CALIB_NVS_NAMESPACE     "sensor"    // legacy standalone blob (imported into settings store)
+#define CALIB_NVS_KEY           "calib"
+#define CALIB_VERSION           1
+#define CALIB_TABLE_SIZE        8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief per unit calibration (stored as a section of the settings blob)
+ * lux = table((lux_linear - dark_offset) * gain / glass_transmittance + offset)
+ */
+typedef struct calibration_data {
+    uint16_t version;
+    uint16_t table_size;        // number of valid piecewise linear points (0: no table)
+    float gain;
+    float offset;               // unit: lux
+    float glass_transmittance;  // cover glass / diffuser transmittance (0 ~ 1]
+    float dark_offset;          // unit: lux
+    float table_in[CALIB_TABLE_SIZE];   // ascending, unit: lux
+    float table_out[CALIB_TABLE_SIZE];  // unit: lux
+} calibration_data_t;
+
+class CLuxCalibration
+{
+public:
+    CLuxCalibration();
+    virtual ~CLuxCalibration();
+    static CLuxCalibration* Instance();
+
+public:
+    bool load();
+    bool save();
+    void reset();
+
+    float apply(float lux_linear);
+
+    bool set_coefficients(float gain, float offset, float glass_transmittance);
+    bool set_dark_offset(float dark_offset);
+    bool set_table(const float *table_in, const float *table_out, uint16_t size);
+    const calibration_data_t* get_data() { return &m_data; }
+    void print_info();
+
+    static void set_default(calibration_data_t *data);
+
+private:
+    static CLuxCalibration *_instance;
+    calibration_data_t m_data;
+
+    // precomputed segments on linear lux domain (lux = slope * lux_linear + intercept)
+    typedef struct segment {
+        float start;
+        float slope;
+        float intercept;
+    } segment_t;
+    typedef struct segment_table {
+        segment_t segments[CALIB_TABLE_SIZE + 1];
+        uint16_t count;
+    } segment_table_t;
+    // lock free for apply() (measurement / burst tasks): writer (console, sensor init) builds the inactive
+    // table then publishes it, readers retry when a table was published meanwhile
+    segment_table_t m_tables[2];
+    std::atomic<uint32_t> m_revision;   // active table: m_tables[m_revision & 1]
+
+    bool validate(const calibration_data_t *data);
+    void build_segments();
+};
+
+inline CLuxCalibration* GetLuxCalibration() {
+    return CLuxCalibration::Instance();
+}
+
+#ifdef __cplusplus
+};
+#endif
+#endif
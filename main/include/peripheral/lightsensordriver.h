@@ -0,0 +1,129 @@
+#pragma once
+#ifndef _LIGHT_SENSOR_DRIVER_H_
+#define _LIGHT_SENSOR_DRIVER_H_
+
+#include <stdint.h>
+#include "I2CMaster.h"
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    RangingAuto = 0,    // gain / integration time adjusted for every measurement
+    RangingFixed,       // fixed gain / integration time
+    RangingPolicyCount
+} eRangingPolicy;
+
+typedef struct light_sample {
+    float lux;
+    uint16_t raw;               // visible (ALS) channel output count
+    uint16_t raw_aux;           // broadband (WHITE / IR) channel output count of the same conversion (0: none)
+    uint8_t gain;               // backend register value
+    uint8_t integ_time;         // backend register value
+    uint16_t conversion_ms;     // conversion (integration) time of this sample
+    uint8_t source_class;       // eLightSourceClass
+    uint16_t color_temperature; // unit: kelvin (0: unknown)
+    bool clipped;               // saturated even at the least sensitive configuration (lux is a lower bound)
+} light_sample_t;
+
+/**
+ * @brief position in the backend range table (index 0: least sensitive)
+ */
+typedef struct light_range {
+    int gain_idx;
+    int integ_idx;
+} light_range_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief light sensor driver interface, static dispatch (CRTP) to the backend T
+ *
+ * backend provides (may be private, with CLightSensorDriver<T> as friend):
+ * - bool driver_initialize(CI2CMaster *), bool driver_release()
+ * - void driver_detach() (device gone: drop driver state, no bus access)
+ * - bool driver_read_measurement(light_sample_t *)
+ * - bool driver_set_ranging_policy(eRangingPolicy, uint8_t fixed_gain, uint8_t fixed_integ_time)
+ * - bool driver_set_power_saving(bool, uint8_t mode)
+ * - void driver_print_ranging_statistics(), void driver_reset_ranging_statistics()
+ * ranging hooks used by auto_range():
+ * - RangeLowCount, RangeHighCount: output count window of auto ranging
+ * - bool range_apply(const light_range_t &), bool range_up(light_range_t *), bool range_down(light_range_t *)
+ * - bool read_raw(uint16_t *raw), bool read_raw_aux(uint16_t *raw_aux) (same conversion as the last read_raw)
+ * - static bool is_saturated(uint16_t raw, uint16_t raw_aux)
+ *
+ * bus access of a backend goes through CI2CMaster only, so a host build can link a register model instead
+ * (scripts/veml7700_ranging_test.cpp)
+ */
+template <class T>
+class CLightSensorDriver
+{
+public:
+    bool initialize(CI2CMaster *i2c_master) { return self()->driver_initialize(i2c_master); }
+    bool release() { return self()->driver_release(); }
+    void detach() { self()->driver_detach(); }
+
+    // read measurement
+    bool read_measurement(light_sample_t *sample) { return self()->driver_read_measurement(sample); }
+    bool read_measurement(float *result) {
+        light_sample_t sample;
+        if (!self()->driver_read_measurement(&sample))
+            return false;
+        if (result)
+            *result = sample.lux;
+        return true;
+    }
+
+    // ranging policy and power saving mode (applied from the next measurement, register values of the backend)
+    bool set_ranging_policy(eRangingPolicy policy, uint8_t fixed_gain, uint8_t fixed_integ_time) {
+        return self()->driver_set_ranging_policy(policy, fixed_gain, fixed_integ_time);
+    }
+    bool set_power_saving(bool enable, uint8_t mode = 0) { return self()->driver_set_power_saving(enable, mode); }
+    void print_ranging_statistics() { self()->driver_print_ranging_statistics(); }
+    void reset_ranging_statistics() { self()->driver_reset_ranging_statistics(); }
+
+protected:
+    T* self() { return static_cast<T *>(this); }
+
+    /**
+     * @brief common auto ranging: starts at *range, steps sensitivity until output count is within
+     * [RangeLowCount, RangeHighCount], jumps to the least sensitive range when saturated
+     * @param[out] steps number of range changes
+     */
+    bool auto_range(light_range_t *range, uint16_t *raw, uint16_t *raw_aux, uint32_t *steps) {
+        T *drv = self();
+        bool ok = drv->range_apply(*range) && drv->read_raw(raw) && drv->read_raw_aux(raw_aux);
+        if (ok && !T::is_saturated(*raw, *raw_aux)) {
+            if (*raw <= T::RangeLowCount) {
+                while (ok && (*raw <= T::RangeLowCount) && drv->range_up(range)) {
+                    (*steps)++;
+                    ok = drv->range_apply(*range) && drv->read_raw(raw);
+                }
+            } else {
+                while (ok && (*raw > T::RangeHighCount) && drv->range_down(range)) {
+                    (*steps)++;
+                    ok = drv->range_apply(*range) && drv->read_raw(raw);
+                }
+            }
+            ok = ok && drv->read_raw_aux(raw_aux);
+        }
+
+        if (ok && T::is_saturated(*raw, *raw_aux) && (range->gain_idx != 0 || range->integ_idx != 0)) {
+            // pinned output: jump directly to the least sensitive configuration (single conversion)
+            GetMetrics()->increment(MetricSaturationRecovery);
+            (*steps)++;
+            range->gain_idx = 0;
+            range->integ_idx = 0;
+            ok = drv->range_apply(*range) && drv->read_raw(raw) && drv->read_raw_aux(raw_aux);
+        }
+
+        return ok;
+    }
+};
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef _LUX_CORRECTION_H_
+#define _LUX_CORRECTION_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief whether non-linearity correction applies to the reading
+ * (datasheet / application note: only for gain 1/8 and 1/4, regardless of integration time)
+ */
+bool lux_correction_required(uint8_t gain, uint8_t integ_time, uint16_t raw);
+
+/**
+ * @brief apply non-linearity correction with precomputed piecewise linear table
+ * table covers linear lux 0 ~ 24.6k (0 ~ 140 klx corrected), extrapolated with the last segment beyond
+ */
+float lux_correction_apply(float lux_linear);
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef _REG_FIELD_H_
+#define _REG_FIELD_H_
+
+#include <stdint.h>
+
+/**
+ * @brief register descriptor (register code and width)
+ */
+template <uint8_t Code, typename Reg = uint16_t>
+struct reg_def {
+    typedef Reg value_type;
+    static constexpr uint8_t code = Code;
+};
+
+/**
+ * @brief register bit field descriptor, mask / shift are generated at compile time
+ * @tparam Allowed allowed field values (empty: any value which fits in Width bits)
+ */
+template <class Register, unsigned Offset, unsigned Width, uint8_t... Allowed>
+struct reg_field {
+    typedef Register reg;
+    typedef typename Register::value_type value_type;
+
+    static_assert(Width > 0 && Width <= 8, "field width should be 1 ~ 8 bits");
+    static_assert(Offset + Width <= sizeof(value_type) * 8, "field exceeds register width");
+
+    static constexpr unsigned offset = Offset;
+    static constexpr unsigned width = Width;
+    static constexpr uint8_t max_value = (uint8_t)((1u << Width) - 1u);
+    static constexpr value_type mask = (value_type)((unsigned)max_value << Offset);
+
+    static_assert(((Allowed <= max_value) && ...), "allowed value does not fit in the field");
+
+    static constexpr bool is_valid(uint8_t value) {
+        if constexpr (sizeof...(Allowed) == 0) {
+            return value <= max_value;
+        } else {
+            return ((value == Allowed) || ...);
+        }
+    }
+    static constexpr uint8_t get(value_type reg_val) {
+        return (uint8_t)((reg_val & mask) >> Offset);
+    }
+    static constexpr value_type set(value_type reg_val, uint8_t value) {
+        return (value_type)((reg_val & (value_type)~mask) | (((value_type)value << Offset) & mask));
+    }
+    static constexpr value_type encode(uint8_t value) {
+        return set(0, value);
+    }
+};
+
+/**
+ * @brief union of field masks, for static_assert checked register maps
+ */
+template <class... Fields>
+constexpr unsigned reg_fields_mask() {
+    return (0u | ... | (unsigned)Fields::mask);
+}
+
+/**
+ * @brief true when no two fields share a bit
+ */
+template <class... Fields>
+constexpr bool reg_fields_disjoint() {
+    return reg_fields_mask<Fields...>() == (0u + ... + (unsigned)Fields::mask);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef _SENSOR_BACKEND_H_
+#define _SENSOR_BACKEND_H_
+
+#include "lightsensordriver.h"
+#include "discovery.h"
+#include "veml7700.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief light sensor backend selected at build time (static dispatch, no virtual call per sample)
+ */
+typedef CVeml7700Ctrl CLightSensorBackend;
+#define LIGHT_SENSOR_PART   PartVeml7700    /**< bus discovery part (discovery.h) */
+
+inline CLightSensorDriver<CLightSensorBackend>* GetLightSensorDriver() {
+    return GetVeml7700Ctrl();
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef _SPECTRAL_H_
+#define _SPECTRAL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    LightSourceUnknown = 0,
+    LightSourceIncandescent,    // incandescent, halogen (strong IR)
+    LightSourceDaylight,
+    LightSourceFluorescent,
+    LightSourceLED,
+    LightSourceClassCount
+} eLightSourceClass;
+
+/**
+ * @brief estimate light source class and approximate correlated color temperature
+ * from ALS / WHITE channel ratio of the same conversion cycle
+ * @param[out] cct unit: kelvin (0 if unknown)
+ */
+eLightSourceClass estimate_light_source(uint16_t als_raw, uint16_t white_raw, uint16_t *cct);
+
+/**
+ * @brief light source specific lux correction factor
+ */
+float get_light_source_lux_factor(eLightSourceClass source);
+
+const char* get_light_source_name(eLightSourceClass source);
+
+#define LIGHT_SOURCE_DEBOUNCE_COUNT 3   // consecutive samples of a new source class before it is taken
+
+/**
+ * @brief light source class of a sample stream: the boundaries of the current class are widened by a
+ * ratio hysteresis and a new class is taken after LIGHT_SOURCE_DEBOUNCE_COUNT consecutive samples,
+ * so the lux factor does not flip between neighbour classes sample by sample
+ */
+class CLightSourceTracker
+{
+public:
+    CLightSourceTracker();
+
+    void reset();
+    // @param[out] cct unit: kelvin (0 if unknown), estimated with the returned class
+    eLightSourceClass update(uint16_t als_raw, uint16_t white_raw, uint16_t *cct);
+
+private:
+    eLightSourceClass m_source;
+    uint16_t m_cct;
+    eLightSourceClass m_pending_source;
+    uint8_t m_pending_count;
+};
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -3,24 +3,77 @@
 #define _VEML7700_H_
 
 #include "I2CMaster.h"
+#include "lightsensordriver.h"
+#include "veml7700reg.h"
+#include "spectral.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <atomic>
+
+#define VEML7700_I2CADDR_DEFAULT    0x10    /**< I2C address */
+
+#define VEML7700_BURST_BUFFER_SIZE  256
+#define VEML7700_SATURATION_COUNT   0xFF00  /**< ALS/WHITE output regarded as pinned (clipped) */
+#define VEML7700_RETAINED_MAGIC     0x56454D4C  /**< "VEML" (rtc retained state) */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-class CVeml7700Ctrl
+typedef struct veml7700_burst_sample {
+    int64_t timestamp_us;
+    uint16_t raw;
+    float lux;
+    bool clipped;
+} veml7700_burst_sample_t;
+
+/**
+ * @brief driver state kept in rtc slow memory (RTC_NOINIT) across software / watchdog / panic resets,
+ * sensor itself keeps running through such resets
+ */
+typedef struct veml7700_retained_state {
+    uint32_t magic;
+    uint16_t dev_id;
+    uint16_t config_reg_val;
+    uint16_t pwr_save_reg_val;
+    uint8_t gain;               // last good configuration of auto ranging
+    uint8_t integ_time;
+    float lux;                  // last measured
+    uint32_t checksum;          // crc32 of the preceding fields
+} veml7700_retained_state_t;
+
+/**
+ * @brief VEML7700 backend of the light sensor driver interface (lightsensordriver.h)
+ */
+class CVeml7700Ctrl : public CLightSensorDriver<CVeml7700Ctrl>
 {
+    friend class CLightSensorDriver<CVeml7700Ctrl>;
+
 public:
     CVeml7700Ctrl();
     virtual ~CVeml7700Ctrl();
     static CVeml7700Ctrl* Instance();
 
 public:
-    bool initialize(CI2CMaster *i2c_master);
-    bool release();
+    // last lux before a warm restart (false after a cold start), published as the first report
+    bool get_retained_lux(float *lux);
+
+    // burst (high rate) sampling with fixed gain and integration time
+    // period_us: 0 = back to back conversions, longer than the integration time = conversion restarted
+    // at every sample, so the integration window is locked to the sample clock (not rounded to ticks)
+    bool start_burst(uint8_t gain, uint8_t integ_time, uint32_t sample_count = 0, uint32_t period_us = 0);
+    bool stop_burst();
+    bool is_burst_running() { return m_burst_running; }
+    float get_burst_sample_rate();
+    size_t get_burst_available();
+    size_t read_burst_block(veml7700_burst_sample_t *samples, size_t max_count, uint16_t decimation = 1);
+    uint32_t get_burst_overrun_count() { return m_burst_overrun_count; }
 
-    // read measurement
-    bool read_measurement(float *result);
+    eRangingPolicy get_ranging_policy() { return m_ranging_policy; }
+
+    // calibration (sensor should be covered while capturing dark offset)
+    bool capture_dark_offset(float *dark_lux, int sample_count = 4);
 
     // related to configuration register
     bool power_on();
@@ -45,10 +98,68 @@ private:
     static CVeml7700Ctrl *_instance;
     CI2CMaster *m_i2c_master;
 
+    // light sensor driver interface
+    bool driver_initialize(CI2CMaster *i2c_master);
+    bool driver_release();
+    void driver_detach();
+    bool driver_read_measurement(light_sample_t *sample);
+    bool driver_set_ranging_policy(eRangingPolicy policy, uint8_t fixed_gain, uint8_t fixed_integ_time);
+    bool driver_set_power_saving(bool enable, uint8_t mode);
+    void driver_print_ranging_statistics();
+    void driver_reset_ranging_statistics();
+
+    // ranging hooks (gain 1/8 ~ 2, integration time 25ms ~ 800ms)
+    static constexpr uint16_t RangeLowCount = 100;
+    static constexpr uint16_t RangeHighCount = 10000;
+    bool range_apply(const light_range_t &range);
+    bool range_up(light_range_t *range);
+    bool range_down(light_range_t *range);
+    bool read_raw(uint16_t *raw) { return read_als_high_resolution_output_data(raw); }
+    bool read_raw_aux(uint16_t *raw_aux) { return read_white_channel_output_data(raw_aux, false); }
+
     uint16_t m_config_reg_val;
     uint16_t m_pwr_save_reg_val;
-
-    float convert_raw_to_lux(uint16_t raw, bool correction);
+    SemaphoreHandle_t m_mutex;
+
+    eRangingPolicy m_ranging_policy;
+    uint8_t m_fixed_gain;
+    uint8_t m_fixed_integ_time;
+    uint32_t m_ranging_usage[4][6];     // [gain register value][integration time index (25ms ~ 800ms)]
+    CLightSourceTracker m_light_source;
+
+    // settings requested while the sensor is busy (burst, measurement), applied by the next holder of m_mutex
+    static constexpr uint32_t PendingValid = 0x80000000;
+    std::atomic<uint32_t> m_pending_ranging;        // valid | policy << 16 | fixed gain << 8 | fixed integration time
+    std::atomic<uint32_t> m_pending_power_saving;   // valid | enable << 8 | mode
+    bool try_apply_pending_settings();
+    bool apply_pending_settings();
+
+    // warm restart (rtc retained state)
+    uint16_t m_dev_id;
+    bool m_warm_started;
+    int m_resume_gain_idx;              // first auto ranging starts here (-1: default)
+    int m_resume_integ_idx;
+    bool restore_retained_state(uint16_t dev_id);
+    void save_retained_state(uint8_t gain, uint8_t integ_time, float lux);
+    static void invalidate_retained_state();
+
+    std::atomic<bool> m_burst_running;
+    TaskHandle_t m_burst_task_handle;
+    uint8_t m_burst_gain;
+    uint8_t m_burst_integ_time;
+    uint32_t m_burst_sample_count;
+    uint32_t m_burst_period_us;
+    bool m_burst_triggered;
+    veml7700_burst_sample_t m_burst_buffer[VEML7700_BURST_BUFFER_SIZE];
+    std::atomic<uint32_t> m_burst_head;
+    std::atomic<uint32_t> m_burst_tail;
+    uint32_t m_burst_overrun_count;
+
+    static void task_burst_function(void *param);
+    static void burst_timer_callback(void *arg);
+
+    float convert_raw_to_lux(uint16_t raw, uint8_t gain, uint8_t integ_time, float source_factor = 1.f);
+    static bool is_saturated(uint16_t als, uint16_t white);
 
     bool read_register_common(uint8_t code, uint16_t *value);
     bool write_register_common(uint8_t code, uint16_t value);
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef _VEML7700_REG_H_
+#define _VEML7700_REG_H_
+
+#include "regfield.h"
+
+#define VEML7700_GAIN_1             0x00    /**< ALS gain 1x */
+#define VEML7700_GAIN_2             0x01    /**< ALS gain 2x */
+#define VEML7700_GAIN_1_8           0x02    /**< ALS gain 1/8x */
+#define VEML7700_GAIN_1_4           0x03    /**< ALS gain 1/4x */
+
+#define VEML7700_IT_100MS           0x00    /**< ALS intetgration time 100ms */
+#define VEML7700_IT_200MS           0x01    /**< ALS intetgration time 200ms */
+#define VEML7700_IT_400MS           0x02    /**< ALS intetgration time 400ms */
+#define VEML7700_IT_800MS           0x03    /**< ALS intetgration time 800ms */
+#define VEML7700_IT_50MS            0x08    /**< ALS intetgration time 50ms */
+#define VEML7700_IT_25MS            0x0C    /**< ALS intetgration time 25ms */
+
+#define VEML7700_PERS_1             0x00    /**< ALS irq persistence 1 sample */
+#define VEML7700_PERS_2             0x01    /**< ALS irq persistence 2 samples */
+#define VEML7700_PERS_4             0x02    /**< ALS irq persistence 4 samples */
+#define VEML7700_PERS_8             0x03    /**< ALS irq persistence 8 samples */
+
+#define VEML7700_POWERSAVE_MODE1    0x00    /**< Power saving mode 1 */
+#define VEML7700_POWERSAVE_MODE2    0x01    /**< Power saving mode 2 */
+#define VEML7700_POWERSAVE_MODE3    0x02    /**< Power saving mode 3 */
+#define VEML7700_POWERSAVE_MODE4    0x03    /**< Power saving mode 4 */
+
+/**
+ * @brief VEML7700 register map (datasheet rev. 1.7), little endian 16bit registers
+ */
+typedef reg_def<0x00> veml7700_reg_als_conf_t;         /**< Light configuration register */
+typedef reg_def<0x01> veml7700_reg_als_wh_t;           /**< Light high threshold for irq */
+typedef reg_def<0x02> veml7700_reg_als_wl_t;           /**< Light low threshold for irq */
+typedef reg_def<0x03> veml7700_reg_power_saving_t;     /**< Power save regiester */
+typedef reg_def<0x04> veml7700_reg_als_t;              /**< The light data output */
+typedef reg_def<0x05> veml7700_reg_white_t;            /**< The white light data output */
+typedef reg_def<0x06> veml7700_reg_als_int_t;          /**< What IRQ (if any) */
+typedef reg_def<0x07> veml7700_reg_id_t;               /**< Device ID */
+
+// ALS_CONF_0 (gain, integration time, persistence: VEML7700_GAIN_x, VEML7700_IT_x, VEML7700_PERS_x)
+typedef reg_field<veml7700_reg_als_conf_t, 0, 1> veml7700_als_sd_t;         /**< 1: shut down */
+typedef reg_field<veml7700_reg_als_conf_t, 1, 1> veml7700_als_int_en_t;     /**< 1: interrupt enabled */
+typedef reg_field<veml7700_reg_als_conf_t, 4, 2> veml7700_als_pers_t;
+typedef reg_field<veml7700_reg_als_conf_t, 6, 4, 0x00, 0x01, 0x02, 0x03, 0x08, 0x0C> veml7700_als_it_t;
+typedef reg_field<veml7700_reg_als_conf_t, 11, 2> veml7700_als_gain_t;
+
+// power saving (VEML7700_POWERSAVE_MODEx)
+typedef reg_field<veml7700_reg_power_saving_t, 0, 1> veml7700_psm_en_t;
+typedef reg_field<veml7700_reg_power_saving_t, 1, 2> veml7700_psm_t;
+
+// interrupt status
+typedef reg_field<veml7700_reg_als_int_t, 14, 1> veml7700_int_th_high_t;
+typedef reg_field<veml7700_reg_als_int_t, 15, 1> veml7700_int_th_low_t;
+
+// device id
+typedef reg_field<veml7700_reg_id_t, 0, 8> veml7700_id_code_t;              /**< 0x81 */
+typedef reg_field<veml7700_reg_id_t, 8, 8> veml7700_id_addr_option_t;       /**< slave address option code */
+
+// reserved bits must stay zero
+static_assert(reg_fields_disjoint<veml7700_als_sd_t, veml7700_als_int_en_t, veml7700_als_pers_t, veml7700_als_it_t, veml7700_als_gain_t>(),
+    "overlapping ALS_CONF_0 fields");
+static_assert(reg_fields_mask<veml7700_als_sd_t, veml7700_als_int_en_t, veml7700_als_pers_t, veml7700_als_it_t, veml7700_als_gain_t>() == 0x1BF3,
+    "ALS_CONF_0 fields do not match the datasheet layout");
+static_assert(reg_fields_mask<veml7700_psm_en_t, veml7700_psm_t>() == 0x0007, "power saving fields do not match the datasheet layout");
+static_assert(reg_fields_mask<veml7700_int_th_high_t, veml7700_int_th_low_t>() == 0xC000, "interrupt status fields do not match the datasheet layout");
+
+#endif
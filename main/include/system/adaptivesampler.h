@@ -0,0 +1,47 @@
+#pragma once
+#ifndef _ADAPTIVE_SAMPLER_H_
+#define _ADAPTIVE_SAMPLER_H_
+
+#include <stdint.h>
+#include "settings.h"
+
+#define ADAPTIVE_LUX_FLOOR          1.f     // relative change is taken against at least this (dark)
+#define ADAPTIVE_NOISE_ALPHA        0.1f    // noise estimate weight of a stable sample
+#define ADAPTIVE_NOISE_FACTOR       3.f     // change below this times noise is regarded as noise
+#define ADAPTIVE_JUMP_FACTOR        4.f     // change above this times threshold jumps to the min period
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief measurement period from signal dynamics: shortened on transitions (halved, or the min period
+ * on a step change), doubled for every stable sample up to the max period
+ */
+class CAdaptiveSampler
+{
+public:
+    CAdaptiveSampler();
+    virtual ~CAdaptiveSampler();
+
+public:
+    void reset();
+    /**
+     * @brief feed a sample, returns the period until the next one
+     * @param conversion_ms conversion time of the sample (lower bound of the period)
+     */
+    uint32_t update(float lux, uint32_t conversion_ms, const sampling_settings_t *settings);
+    uint32_t get_period_ms() { return m_period_ms; }
+    float get_noise_percent() { return m_noise * 100.f; }
+
+private:
+    bool m_has_last;
+    float m_last_lux;
+    float m_noise;          // mean relative change of stable samples
+    uint32_t m_period_ms;
+};
+
+#ifdef __cplusplus
+}
+#endif
+#endif
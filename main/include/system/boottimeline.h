@@ -0,0 +1,58 @@
+#pragma once
+#ifndef _BOOT_TIMELINE_H_
+#define _BOOT_TIMELINE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    BootPhaseNvs = 0,
+    BootPhasePowerManager,
+    BootPhaseSettings,
+    BootPhaseButton,
+    BootPhaseHistory,
+    BootPhaseRootNode,
+    BootPhaseMatterStart,
+    BootPhaseEndpoint,
+    BootPhaseConsole,
+    BootPhaseSensorInit,        // i2c + calibration + veml7700 (sensor init task, overlaps matter start)
+    BootPhaseFirstSample,       // first conversion incl. auto ranging (sensor init task)
+    BootPhaseFirstReport,       // time to first illuminance report (end only)
+    BootPhaseCount
+} eBootPhase;
+
+/**
+ * @brief boot phase timestamps (esp_timer, since application start)
+ * each phase is recorded by a single task, no locking
+ */
+class CBootTimeline
+{
+public:
+    CBootTimeline();
+    virtual ~CBootTimeline();
+    static CBootTimeline* Instance();
+
+public:
+    void begin(eBootPhase phase);
+    void end(eBootPhase phase);
+    uint32_t get_elapsed_ms(eBootPhase phase);  // from application start to the end of phase (0: not finished)
+    void print_info();
+
+private:
+    static CBootTimeline *_instance;
+    int64_t m_begin_us[BootPhaseCount];
+    int64_t m_end_us[BootPhaseCount];
+};
+
+inline CBootTimeline* GetBootTimeline() {
+    return CBootTimeline::Instance();
+}
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool register_console_commands();
+
+#ifdef __cplusplus
+};
+#endif
+#endif
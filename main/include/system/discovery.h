@@ -0,0 +1,61 @@
+#pragma once
+#ifndef _DISCOVERY_H_
+#define _DISCOVERY_H_
+
+#include <stdint.h>
+#include "I2CMaster.h"
+
+#define DISCOVERY_ADDR_FIRST    0x08
+#define DISCOVERY_ADDR_LAST     0x77
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    PartVeml7700 = 0,
+    PartCount
+} eI2CPart;
+
+/**
+ * @brief known part, identified by a 16 bit (little endian) id register
+ */
+typedef struct i2c_part {
+    const char *name;
+    uint8_t dev_addr;
+    uint8_t id_reg;
+    uint16_t id_mask;
+    uint16_t id_value;
+} i2c_part_t;
+
+/**
+ * @brief i2c bus discovery (address probe + id register check)
+ */
+class CBusDiscovery
+{
+public:
+    CBusDiscovery();
+    virtual ~CBusDiscovery();
+    static CBusDiscovery* Instance();
+
+public:
+    bool initialize(CI2CMaster *i2c_master);
+    int scan(uint8_t *found, int max_count);
+    bool identify(eI2CPart part);
+    const i2c_part_t* get_part(eI2CPart part);
+    void print_scan();
+
+private:
+    static CBusDiscovery *_instance;
+    CI2CMaster *m_i2c_master;
+};
+
+inline CBusDiscovery* GetBusDiscovery() {
+    return CBusDiscovery::Instance();
+}
+
+#ifdef __cplusplus
+};
+#endif
+#endif
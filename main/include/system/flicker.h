@@ -0,0 +1,49 @@
+#pragma once
+#ifndef _FLICKER_H_
+#define _FLICKER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "definition.h"
+
+#define FLICKER_BIN_UNSUPPORTED -1.f    // bin_modulation of a bin which cannot be measured at this sample rate
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct flicker_result {
+    uint16_t sample_count;
+    float mean;                 // unit: raw count
+    float percent_modulation;   // 100 * (max - min) / (max + min)
+    float flicker_index;        // area above mean / total area
+    uint16_t mains_frequency;   // 100 or 120 (Hz) if mains flicker detected, 0 otherwise
+    float mains_modulation;     // estimated percent modulation of mains flicker (integration loss compensated)
+    float bin_modulation[FLICKER_BIN_COUNT];    // per mains bin (100, 120, 50, 60 Hz), FLICKER_BIN_UNSUPPORTED if not measurable
+    uint8_t unsupported_bins;   // bit n: bin n aliases to DC / nyquist or falls on an integration null
+} flicker_result_t;
+
+/**
+ * @brief flicker analyser for (low rate) burst captures
+ * mains flicker components (50/60 Hz and harmonics) are far above the sampling rate, so they are measured
+ * at their alias frequencies with a fixed-point Goertzel filter, and compensated by the sinc response
+ * of the sensor integration window. bins aliasing to DC/nyquist or falling on an integration null are reported
+ * as unsupported (not as 0 modulation), FLICKER_BURST_PERIOD_US is chosen to keep 50/60/100 Hz measurable.
+ * CPU time is bounded: at most FLICKER_MAX_SAMPLES samples x FLICKER_BIN_COUNT bins per window.
+ */
+class CFlickerAnalyzer
+{
+public:
+    CFlickerAnalyzer();
+
+public:
+    bool analyze(const uint16_t *samples, size_t count, float sample_rate_hz, float integ_time_sec, flicker_result_t *result);
+
+private:
+    float goertzel_amplitude(const int32_t *samples, size_t count, float normalized_freq);
+};
+
+#ifdef __cplusplus
+};
+#endif
+#endif
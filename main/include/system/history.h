@@ -0,0 +1,93 @@
+#pragma once
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "historycodec.h"
+
+#define HISTORY_NVS_NAMESPACE   "history"
+#define HISTORY_NVS_KEY_BOOT    "boot_count"
+#define HISTORY_EPOCH_MIN       1672531200  // 2023-01-01, earlier time() means the clock was never synced
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+class CHistoryReader;
+
+/**
+ * @brief compressed sample history on dedicated flash partition
+ * partition is used as a ring of HISTORY_PAGE_SIZE pages, a whole sector (oldest pages)
+ * is erased in advance when the write position enters it
+ * samples are stamped with unix time once the clock is synced, otherwise with seconds since boot
+ * together with the persisted boot counter (time() restarts from 0 on every boot without SNTP)
+ */
+class CHistoryStore
+{
+public:
+    CHistoryStore();
+    virtual ~CHistoryStore();
+    static CHistoryStore* Instance();
+
+public:
+    bool initialize();
+    bool append(float value);
+    bool flush();
+    void print_info();
+
+private:
+    friend class CHistoryReader;
+    static CHistoryStore *_instance;
+    bool m_initialized;
+    const esp_partition_t *m_partition;
+    SemaphoreHandle_t m_mutex;
+
+    uint32_t m_page_count;
+    uint32_t m_write_page;
+    uint32_t m_sequence;
+    uint32_t m_written_page_count;
+    uint16_t m_boot_count;
+    CHistoryPageEncoder m_encoder;
+
+    bool load_boot_count();
+
+    bool write_current_page();
+    bool read_page(uint32_t page_index, uint8_t *buffer);
+};
+
+inline CHistoryStore* GetHistoryStore() {
+    return CHistoryStore::Instance();
+}
+
+/**
+ * @brief streaming reader (oldest to newest, including not yet flushed samples)
+ */
+class CHistoryReader
+{
+public:
+    CHistoryReader();
+
+public:
+    bool begin(uint32_t since_timestamp);    // 0: all samples, otherwise unix time (uptime stamped samples are skipped)
+    bool next(history_sample_t *sample);
+
+private:
+    CHistoryStore *m_store;
+    uint32_t m_since_timestamp;
+    uint32_t m_start_page;
+    uint32_t m_pages_visited;
+    bool m_pending_page_visited;
+    uint8_t m_buffer[HISTORY_PAGE_SIZE];
+    CHistoryPageDecoder m_decoder;
+    bool m_decoder_valid;
+
+    bool load_next_page();
+};
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+#ifndef _HISTORY_CODEC_H_
+#define _HISTORY_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HISTORY_PAGE_SIZE       256     // flash program page
+#define HISTORY_PAGE_MAGIC      0x4854  // 'HT' (boot count + clock flag header, 'HS' pages are ignored)
+
+#define HISTORY_FLAG_EPOCH      0x01    // timestamp is unix time (synced clock), otherwise seconds since boot
+
+typedef struct history_sample {
+    uint32_t timestamp;     // unit: second (see flags)
+    float value;
+    uint16_t boot_count;    // boot the sample was taken in
+    uint8_t flags;          // HISTORY_FLAG_x
+} history_sample_t;
+
+/**
+ * @brief page header, first sample is stored uncompressed as base
+ * a page holds samples of a single boot and clock source (boot_count, flags)
+ * records: zigzag varint of timestamp delta-of-delta, then value token
+ * value token: varint(0) if equal to previous value,
+ *              varint(((xor >> tz) << 5) | tz) otherwise (xor of float bit pattern, tz = trailing zeros)
+ */
+typedef struct __attribute__((packed)) history_page_header {
+    uint16_t magic;
+    uint16_t count;
+    uint32_t sequence;
+    uint16_t boot_count;
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t base_timestamp;
+    uint32_t base_value;    // float bit pattern
+    uint32_t crc;           // crc32 of page excluding this field
+} history_page_header_t;
+
+size_t history_varint_encode(uint64_t value, uint8_t *out);
+size_t history_varint_decode(const uint8_t *data, size_t size, uint64_t *value);
+uint32_t history_crc32(uint32_t crc, const uint8_t *data, size_t size);
+
+class CHistoryPageEncoder
+{
+public:
+    CHistoryPageEncoder();
+
+public:
+    void begin(uint32_t sequence, uint16_t boot_count = 0, uint8_t flags = 0);
+    bool append(const history_sample_t *sample);  // false when page is full (boot_count, flags of sample are ignored)
+    void finish();                                  // fill header count, crc
+
+    const uint8_t* get_data() { return m_page; }
+    uint16_t get_count() { return m_count; }
+    size_t get_used_size() { return m_offset; }
+    uint32_t get_sequence() { return m_sequence; }
+    uint16_t get_boot_count() { return m_boot_count; }
+    uint8_t get_flags() { return m_flags; }
+
+private:
+    uint8_t m_page[HISTORY_PAGE_SIZE];
+    size_t m_offset;
+    uint16_t m_count;
+    uint32_t m_sequence;
+    uint16_t m_boot_count;
+    uint8_t m_flags;
+    uint32_t m_prev_timestamp;
+    int64_t m_prev_delta;
+    uint32_t m_prev_value_bits;
+};
+
+class CHistoryPageDecoder
+{
+public:
+    CHistoryPageDecoder();
+
+public:
+    bool begin(const uint8_t *page, size_t size);   // false if page is erased or corrupted
+    bool next(history_sample_t *sample);
+
+    uint32_t get_sequence() { return m_sequence; }
+    uint16_t get_count() { return m_count; }
+    uint16_t get_boot_count() { return m_boot_count; }
+    uint8_t get_flags() { return m_flags; }
+
+private:
+    const uint8_t *m_page;
+    size_t m_size;
+    size_t m_offset;
+    uint16_t m_count;
+    uint16_t m_index;
+    uint32_t m_sequence;
+    uint16_t m_boot_count;
+    uint8_t m_flags;
+    uint32_t m_prev_timestamp;
+    int64_t m_prev_delta;
+    uint32_t m_prev_value_bits;
+};
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef _JSON_WRITER_H_
+#define _JSON_WRITER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JSON_WRITER_CHUNK_SIZE  128     // output is delivered to the sink in chunks of this size
+#define JSON_WRITER_MAX_DEPTH   8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*json_sink_t)(const char *data, size_t len, void *ctx);
+
+typedef struct json_buffer {
+    char *data;
+    size_t size;
+    size_t len;         // may exceed size (required size, output truncated)
+} json_buffer_t;
+
+void json_sink_stdout(const char *data, size_t len, void *ctx);
+void json_sink_buffer(const char *data, size_t len, void *ctx);   // ctx: json_buffer_t*
+
+/**
+ * @brief allocation-free streaming json emitter
+ * key is ignored (nullptr) for array elements and the root value
+ */
+class CJsonWriter
+{
+public:
+    CJsonWriter(json_sink_t sink, void *ctx);
+    virtual ~CJsonWriter();
+
+public:
+    bool begin_object(const char *key = nullptr);
+    bool end_object();
+    bool begin_array(const char *key = nullptr);
+    bool end_array();
+
+    void write_string(const char *key, const char *value, int max_len = -1);
+    void write_int(const char *key, int64_t value);
+    void write_uint(const char *key, uint64_t value);
+    void write_float(const char *key, double value);
+    void write_bool(const char *key, bool value);
+    void write_null(const char *key);
+    void write_hex(const char *key, uint32_t value, int width);     // as string, e.g. "0x00FF"
+
+    // deliver buffered output to the sink (call once at the end)
+    void flush();
+    bool is_valid() { return m_valid; }
+
+private:
+    json_sink_t m_sink;
+    void *m_ctx;
+    char m_buffer[JSON_WRITER_CHUNK_SIZE];
+    size_t m_length;
+    int m_depth;
+    bool m_first[JSON_WRITER_MAX_DEPTH + 1];
+    bool m_valid;   // false on nesting overflow / underflow
+
+    void put(char c);
+    void put(const char *str);
+    void put_escaped(const char *str, int max_len);
+    void begin_value(const char *key);
+};
+
+#ifdef __cplusplus
+};
+#endif
+#endif
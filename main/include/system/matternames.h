@@ -0,0 +1,23 @@
+#pragma once
+#ifndef _MATTER_NAMES_H_
+#define _MATTER_NAMES_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief human readable names of matter ids ("?" if unknown or CONFIG_APP_MATTER_NAME_TABLE is off)
+ * no esp-matter dependency, so the tables can be checked by a host build (scripts/matter_names_test.cpp)
+ */
+const char* get_matter_device_name(uint16_t device_id);
+const char* get_matter_cluster_name(uint32_t cluster_id);
+const char* get_matter_attribute_name(uint32_t cluster_id, uint32_t attribute_id);
+const char* get_matter_command_name(uint32_t cluster_id, uint32_t command_id);
+
+#ifdef __cplusplus
+};
+#endif
+#endif
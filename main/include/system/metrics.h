@@ -0,0 +1,99 @@
+#pragma once
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#define METRIC_HISTOGRAM_BUCKET_COUNT   8   // [0, base), [base, 2 base), ..., [64 base, inf)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    MetricSampleCount = 0,      // completed measurements
+    MetricRangingSteps,         // gain / integration time changes while auto ranging
+    MetricSaturationRecovery,   // fast recovery from pinned output
+    MetricClippedSamples,       // saturated at the least sensitive configuration
+    MetricBurstOverrun,         // burst samples lost (ring buffer full)
+    MetricI2CTransaction,
+    MetricI2CError,
+    MetricAttributeReport,      // matter attribute updates
+    MetricAttributeReportFailed,
+    MetricSampleFailed,         // measurement aborted by i2c failure
+    MetricI2CRetry,             // transfer attempts after a failure
+    MetricI2CBusRecovery,       // scl toggle bus clear + driver reinstall
+    MetricI2CBreakerOpen,       // device circuit breaker trips
+    MetricI2CBreakerRejected,   // transfers refused while circuit is open
+    MetricSampleDropped,        // samples not published (matter context queue full)
+    MetricCounterCount
+} eMetricCounter;
+
+typedef enum
+{
+    MetricHeapMinFree = 0,      // unit: byte (low-water mark since boot)
+    MetricHeapFree,             // unit: byte
+    MetricTaskStackMinFree,     // unit: byte (smallest headroom among application tasks)
+    MetricBootTimeToFirstReport,    // unit: ms (application start to the first illuminance report)
+    MetricSamplePeriod,         // unit: ms (current measurement period, adaptive)
+    MetricGaugeCount
+} eMetricGauge;
+
+typedef enum
+{
+    MetricSampleLatency = 0,    // read_measurement duration, unit: ms (base 25)
+    MetricI2CLatency,           // i2c transaction duration, unit: us (base 100)
+    MetricSampleJitter,         // measurement start delay from its schedule, unit: us (base 500)
+    MetricHistogramCount
+} eMetricHistogram;
+
+typedef struct metric_histogram {
+    uint32_t base;
+    uint32_t buckets[METRIC_HISTOGRAM_BUCKET_COUNT];
+    uint32_t count;
+    uint64_t sum;
+    uint32_t max;
+} metric_histogram_t;
+
+/**
+ * @brief lock-free metrics registry (safe to update from any task)
+ */
+class CMetrics
+{
+public:
+    CMetrics();
+    virtual ~CMetrics();
+    static CMetrics* Instance();
+
+public:
+    void increment(eMetricCounter type, uint32_t value = 1);
+    void set_gauge(eMetricGauge type, uint32_t value);
+    void record(eMetricHistogram type, uint32_t value);
+
+    uint32_t get_counter(eMetricCounter type);
+    uint32_t get_gauge(eMetricGauge type);
+    bool get_histogram(eMetricHistogram type, metric_histogram_t *histogram);
+
+    void reset();
+    void print_info();
+
+private:
+    static CMetrics *_instance;
+
+    std::atomic<uint32_t> m_counters[MetricCounterCount];
+    std::atomic<uint32_t> m_gauges[MetricGaugeCount];
+    std::atomic<uint32_t> m_histogram_buckets[MetricHistogramCount][METRIC_HISTOGRAM_BUCKET_COUNT];
+    std::atomic<uint64_t> m_histogram_sum[MetricHistogramCount];
+    std::atomic<uint32_t> m_histogram_max[MetricHistogramCount];
+};
+
+inline CMetrics* GetMetrics() {
+    return CMetrics::Instance();
+}
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef _POWER_MANAGER_H_
+#define _POWER_MANAGER_H_
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_pm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    I2CTransaction = 0,     // APB max frequency + no light sleep
+    SensorIntegration,      // no light sleep
+    ConsoleActive,          // no light sleep
+    PmLockTypeCount
+} ePmLockType;
+
+class CPowerManager
+{
+public:
+    CPowerManager();
+    virtual ~CPowerManager();
+    static CPowerManager* Instance();
+
+public:
+    bool initialize(int max_freq_mhz, int min_freq_mhz, bool light_sleep_enable);
+
+    void acquire(ePmLockType type);
+    void release(ePmLockType type);
+
+    // console input wakes the chip from light sleep (characters received until it is awake are lost)
+    bool enable_uart_wakeup(int uart_num);
+
+    void print_statistics();
+
+private:
+    static CPowerManager *_instance;
+    bool m_initialized;
+    int64_t m_init_time_us;
+    portMUX_TYPE m_spinlock;
+
+    esp_pm_lock_handle_t m_lock_apb_freq_max;
+    esp_pm_lock_handle_t m_lock_no_light_sleep[PmLockTypeCount];
+
+    // per lock type time accounting
+    int m_lock_depth[PmLockTypeCount];
+    uint32_t m_lock_count[PmLockTypeCount];
+    int64_t m_lock_acquired_us[PmLockTypeCount];
+    int64_t m_lock_held_us[PmLockTypeCount];
+};
+
+inline CPowerManager* GetPowerManager() {
+    return CPowerManager::Instance();
+}
+
+/**
+ * @brief scoped power management lock (released when goes out of scope)
+ */
+class CPmLockGuard
+{
+public:
+    explicit CPmLockGuard(ePmLockType type) : m_type(type) {
+        GetPowerManager()->acquire(m_type);
+    }
+    ~CPmLockGuard() {
+        GetPowerManager()->release(m_type);
+    }
+
+private:
+    ePmLockType m_type;
+};
+
+#ifdef __cplusplus
+};
+#endif
+#endif
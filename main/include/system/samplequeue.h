@@ -0,0 +1,47 @@
+#pragma once
+#ifndef _SAMPLE_QUEUE_H_
+#define _SAMPLE_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "definition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct report_sample {
+    int64_t timestamp_us;       // measurement start
+    float lux;                  // filtered value
+    bool report_lux;            // deadband exceeded (publish measured value)
+    bool light_source;          // source_class / color_temperature valid (not for a retained value)
+    uint8_t source_class;       // eLightSourceClass
+    uint16_t color_temperature; // unit: kelvin (0: unknown)
+} report_sample_t;
+
+/**
+ * @brief lock-free single producer (measurement task) / single consumer (matter context) sample ring,
+ * newest sample is dropped when full (MetricSampleDropped)
+ */
+class CSampleQueue
+{
+public:
+    CSampleQueue();
+    virtual ~CSampleQueue();
+
+public:
+    bool push(const report_sample_t *sample);   // producer only
+    bool pop(report_sample_t *sample);          // consumer only
+    size_t get_count();
+
+private:
+    report_sample_t m_buffer[SAMPLE_QUEUE_LENGTH];
+    std::atomic<uint32_t> m_head;
+    std::atomic<uint32_t> m_tail;
+};
+
+#ifdef __cplusplus
+}
+#endif
+#endif
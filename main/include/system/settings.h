@@ -0,0 +1,109 @@
+#pragma once
+#ifndef _SETTINGS_H_
+#define _SETTINGS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "calibration.h"
+
+#define SETTINGS_NVS_NAMESPACE      "config"
+#define SETTINGS_NVS_KEY            "settings"
+#define SETTINGS_VERSION            1
+#define SETTINGS_COMMIT_DELAY_MS    5000    // writes are coalesced until no change for this period
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sensor_settings {
+    uint32_t period_ms;         // measurement period
+    uint8_t ranging_policy;     // eRangingPolicy
+    uint8_t fixed_gain;         // VEML7700_GAIN_xxx (fixed ranging)
+    uint8_t fixed_integ_time;   // VEML7700_IT_xxx (fixed ranging)
+    uint8_t power_saving_mode;  // 0: disabled, 1 ~ 4: power saving mode 1 ~ 4
+    float deadband_percent;     // matter report is skipped while relative change is below (0: report every change)
+    float filter_alpha;         // exponential moving average weight of a new sample (1: no filtering)
+} sensor_settings_t;
+
+typedef struct sampling_settings {
+    uint8_t adaptive;           // 0: fixed period (sensor settings), 1: adaptive between min / max period
+    uint32_t min_period_ms;     // during transitions (bounded below by one conversion time)
+    uint32_t max_period_ms;     // while stable
+    float change_percent;       // relative change per sample regarded as a transition (raised to the noise level)
+} sampling_settings_t;
+
+/**
+ * @brief nvs blob layout (append only: new sections / fields are added at the end,
+ * missing tail of an older blob keeps default values)
+ */
+typedef struct settings_blob {
+    uint16_t version;
+    uint16_t length;            // sizeof(settings_blob_t) of the firmware which wrote the blob
+    sensor_settings_t sensor;
+    calibration_data_t calibration;
+    sampling_settings_t sampling;
+} settings_blob_t;
+
+/**
+ * @brief runtime configuration store (one versioned nvs blob, cached in ram)
+ * readers never lock (double buffered cache), writers only mark the cache dirty,
+ * flash commit is done by a low priority task after SETTINGS_COMMIT_DELAY_MS without change
+ */
+class CSettings
+{
+public:
+    CSettings();
+    virtual ~CSettings();
+    static CSettings* Instance();
+
+public:
+    bool initialize();
+    bool commit();
+
+    void get(sensor_settings_t *settings);
+    bool set(const sensor_settings_t *settings);
+    void get_calibration(calibration_data_t *calibration);
+    bool set_calibration(const calibration_data_t *calibration);
+    void get_sampling(sampling_settings_t *sampling);
+    bool set_sampling(const sampling_settings_t *sampling);
+    void reset();
+    void print_info();
+
+    static void set_default(sensor_settings_t *settings);
+    static bool validate(const sensor_settings_t *settings);
+    static void set_default(sampling_settings_t *sampling);
+    static bool validate(const sampling_settings_t *sampling);
+
+private:
+    static CSettings *_instance;
+    bool m_initialized;
+    SemaphoreHandle_t m_mutex;          // serializes writers only
+    TaskHandle_t m_task_commit_handle;
+
+    settings_blob_t m_cache[2];
+    std::atomic<uint32_t> m_revision;   // active cache: m_cache[m_revision & 1]
+    std::atomic<uint32_t> m_committed_revision;
+    uint32_t m_commit_count;
+    esp_err_t m_last_commit_result;
+
+    void read(settings_blob_t *blob);
+    void write(const settings_blob_t *blob);
+    bool load(settings_blob_t *blob);
+    bool migrate(const uint8_t *data, size_t length, settings_blob_t *blob);
+    bool import_legacy_calibration(settings_blob_t *blob);
+
+    static void task_commit_function(void *param);
+};
+
+inline CSettings* GetSettings() {
+    return CSettings::Instance();
+}
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+#ifndef _STATISTICS_H_
+#define _STATISTICS_H_
+
+#include <stdint.h>
+#include "definition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct statistics_result {
+    uint32_t window_sec;        // configured window length
+    uint32_t count;             // number of samples within window
+    float min;
+    float max;
+    float mean;                 // arithmetic mean of samples
+    float time_weighted_mean;   // integral / covered time
+    float variance;             // population variance of samples
+    float integral;             // time-weighted integral (unit: value * hour)
+} statistics_result_t;
+
+/**
+ * @brief sliding window aggregates in fixed memory
+ * window is divided into STAT_BUCKET_COUNT buckets, running totals are updated in O(1)
+ * per sample and the oldest bucket is subtracted when the window slides
+ */
+class CStatisticsWindow
+{
+public:
+    CStatisticsWindow();
+
+public:
+    void configure(uint32_t window_sec);
+    void set_hold_limit(int64_t hold_limit_us);     // longest gap integrated as zero-order hold
+    void reset();
+    void push(float value, int64_t timestamp_us);
+    bool get_result(int64_t timestamp_us, statistics_result_t *result);
+    uint32_t get_window_sec() { return m_window_sec; }
+
+private:
+    typedef struct bucket {
+        float min;
+        float max;
+        double sum;
+        double sum_sq;
+        double integral;    // unit: value * us
+        int64_t duration_us;
+        uint32_t count;
+    } bucket_t;
+
+    bucket_t m_buckets[STAT_BUCKET_COUNT];
+    uint32_t m_window_sec;
+    int64_t m_bucket_span_us;
+    int64_t m_bucket_start_us;
+    int64_t m_hold_limit_us;
+    int m_head;
+
+    double m_sum;
+    double m_sum_sq;
+    double m_integral;
+    int64_t m_duration_us;
+    uint32_t m_count;
+
+    bool m_has_prev;
+    float m_prev_value;
+    int64_t m_prev_timestamp_us;
+
+    void clear_bucket(bucket_t *bucket);
+    void advance(int64_t timestamp_us);
+    void integrate(float value, int64_t from_us, int64_t to_us);
+};
+
+class CLuxStatistics
+{
+public:
+    CLuxStatistics();
+    virtual ~CLuxStatistics();
+    static CLuxStatistics* Instance();
+
+public:
+    bool configure_window(int index, uint32_t window_sec);
+    void set_hold_limit(int64_t hold_limit_us);
+    void reset();
+    void push(float value, int64_t timestamp_us);
+    bool get_result(int index, int64_t timestamp_us, statistics_result_t *result);
+
+private:
+    static CLuxStatistics *_instance;
+    CStatisticsWindow m_windows[STAT_WINDOW_COUNT];
+};
+
+inline CLuxStatistics* GetLuxStatistics() {
+    return CLuxStatistics::Instance();
+}
+
+#ifdef __cplusplus
+};
+#endif
+#endif
@@ -4,16 +4,28 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include <esp_matter.h>
 #include <esp_matter_core.h>
 #include <iot_button.h>
 #include "I2CMaster.h"
 #include "device.h"
+#include "sensorbackend.h"
+#include "samplequeue.h"
+#include "definition.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef void (*system_job_func_t)(void *arg);
+
+typedef struct system_job {
+    system_job_func_t func;
+    void *arg;
+} system_job_t;
+
 class CSystem
 {
 public:
@@ -36,6 +48,17 @@ public:
 
     CDevice* find_device_by_endpoint_id(uint16_t endpoint_id);
 
+    // push runtime sensor settings (settings.h) to the sensor driver
+    bool apply_sensor_settings();
+    // measurement task re-reads the period settings now instead of at its next deadline
+    void wake_measurement_task();
+    bool is_sensor_attached() { return m_sensor_attached; }
+
+    // deferred work (executed in low priority worker task, never blocks the caller)
+    bool post_job(system_job_func_t func, void *arg = nullptr);
+    void print_system_info();
+    void print_matter_endpoints_info();
+
 private:
     static CSystem* _instance;
     bool m_initialized;
@@ -51,8 +74,6 @@ private:
     bool init_default_button();
     bool deinit_default_button();
     static void callback_default_button(void *arg, void *data);
-    void print_system_info();
-    void print_matter_endpoints_info();
 
     static void matter_event_callback(const ChipDeviceEvent *event, intptr_t arg);
     static esp_err_t matter_identification_callback(
@@ -71,11 +92,52 @@ private:
         void *priv_data
     );
 
+    // runtime metrics cluster (root node endpoint)
+    bool matter_create_clus_metrics();
+    void matter_update_clus_metrics_attr(uint32_t attribute_id, esp_matter_attr_val_t value);
+    void matter_update_clus_metrics_attr_all();
+    void update_metrics_gauges();
+    static esp_err_t matter_metrics_reset_command_callback(
+        const chip::app::ConcreteCommandPath &command_path, 
+        chip::TLV::TLVReader &tlv_data, 
+        void *opaque_ptr
+    );
+
 private:
     bool m_keepalive;
     TaskHandle_t m_task_timer_handle;
+    TaskHandle_t m_task_worker_handle;
+    QueueHandle_t m_job_queue;
+    uint16_t m_flicker_samples[FLICKER_MAX_SAMPLES];
+    float m_flicker_integ_time_sec;
+
+    bool start_flicker_capture(float last_lux);
+    void finish_flicker_capture();
 
     static void task_timer_function(void *param);
+    static void task_worker_function(void *param);
+
+    // boot: sensor bring-up + first conversion in parallel with matter startup
+    SemaphoreHandle_t m_sensor_init_done;
+    light_sample_t m_boot_sample;
+    volatile bool m_boot_sample_valid;
+    bool m_boot_sample_retained;    // boot sample is the last lux before a warm restart
+    static void task_sensor_init_function(void *param);
+
+    // sensor hot-plug (endpoint created / destroyed as the sensor appears / disappears)
+    volatile bool m_sensor_present;     // answered at bring-up
+    volatile bool m_sensor_attached;    // endpoint exists
+    int m_sensor_missing_count;
+    bool attach_light_sensor();
+    void detach_light_sensor();
+    void update_sensor_presence();
+
+    // measurement task -> matter context (attribute updates without waiting for the chip stack lock)
+    CSampleQueue m_sample_queue;
+    std::atomic<bool> m_publish_scheduled;
+    bool m_first_reported;              // matter context only
+    void publish_sample(const report_sample_t *sample);
+    static void matter_publish_samples_work(intptr_t arg);
 };
 
 inline CSystem* GetSystem() {
@@ -0,0 +1,92 @@
+#pragma once
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "definition.h"
+
+#define TRACE_TASK_NAME_LEN     10
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct trace_event {
+    uint32_t timestamp_us;          // lower 32 bits of esp_timer (wraps every ~71 minutes)
+    const char *name;               // string literal (not copied)
+    uint32_t arg;
+    char phase;                     // 'B': begin, 'E': end, 'i': instant
+    uint8_t core;
+    char task[TRACE_TASK_NAME_LEN]; // copied since task may be deleted before dump
+} trace_event_t;
+
+/**
+ * @brief begin/end event recorder with preallocated ring buffer
+ * FreeRTOS task switch hooks cannot be installed from application in esp-idf,
+ * so each event carries the name of the task (and core) it was recorded from instead
+ */
+class CTrace
+{
+public:
+    CTrace();
+    virtual ~CTrace();
+    static CTrace* Instance();
+
+public:
+    void start();
+    void stop();
+    void clear();
+    bool is_enabled() { return m_enabled.load(std::memory_order_relaxed); }
+
+    void record(char phase, const char *name, uint32_t arg = 0);
+    // print buffered events (oldest first) as csv lines: timestamp_us,phase,core,task,name,arg
+    void dump();
+
+private:
+    static CTrace *_instance;
+    std::atomic<bool> m_enabled;
+    std::atomic<uint32_t> m_write_index;
+    trace_event_t m_events[TRACE_BUFFER_SIZE];
+};
+
+inline CTrace* GetTrace() {
+    return CTrace::Instance();
+}
+
+/**
+ * @brief scoped begin/end event pair
+ */
+class CTraceScope
+{
+public:
+    explicit CTraceScope(const char *name) : m_name(name) {
+        GetTrace()->record('B', m_name);
+    }
+    ~CTraceScope() {
+        GetTrace()->record('E', m_name);
+    }
+
+private:
+    const char *m_name;
+};
+
+#ifdef __cplusplus
+};
+#endif
+
+#if TRACE_ENABLE
+#define TRACE_BEGIN(name)           GetTrace()->record('B', name)
+#define TRACE_END(name)             GetTrace()->record('E', name)
+#define TRACE_INSTANT(name, arg)    GetTrace()->record('i', name, arg)
+#define TRACE_SCOPE_CONCAT(a, b)    a##b
+#define TRACE_SCOPE_VAR(line)       TRACE_SCOPE_CONCAT(trace_scope_, line)
+#define TRACE_SCOPE(name)           CTraceScope TRACE_SCOPE_VAR(__LINE__)(name)
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_INSTANT(name, arg)
+#define TRACE_SCOPE(name)
+#endif
+
+#endif
@@ -1,6 +1,8 @@
 #include "device.h"
 #include "logger.h"
 #include "system.h"
+#include "metrics.h"
+#include "trace.h"
 
 CDevice::CDevice()
 {
@@ -193,8 +195,12 @@ void CDevice::matter_update_cluster_attribute_common(uint16_t endpoint_id, uint3
     if (value_diff) {
         *updating_flag = true;
 
+        TRACE_BEGIN("matter_attribute_update");
         esp_err_t ret = esp_matter::attribute::update(endpoint_id, cluster_id, attribute_id, &target_value);
+        TRACE_END("matter_attribute_update");
+        GetMetrics()->increment(MetricAttributeReport);
         if (ret != ESP_OK) {
+            GetMetrics()->increment(MetricAttributeReportFailed);
             GetLogger(eLogType::Error)->Log("Failed to update matter attribute (ret: %d)", ret);
         }
     }
@@ -204,3 +210,18 @@ void CDevice::update_measured_value_illuminance(uint16_t value)
 {
     m_measured_value_illuminance = value;
 }
+
+void CDevice::update_illuminance_statistics(const statistics_result_t *results, int count)
+{
+
+}
+
+void CDevice::update_flicker_result(const flicker_result_t *result)
+{
+
+}
+
+void CDevice::update_light_source(uint8_t source_class, uint16_t color_temperature)
+{
+
+}
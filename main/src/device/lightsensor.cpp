@@ -1,11 +1,20 @@
 #include "lightsensor.h"
 #include "system.h"
 #include "logger.h"
+#include "customcluster.h"
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 CLightSensor::CLightSensor()
 {
     m_matter_update_by_client_clus_illummeas_attr_measureval = false;
+    m_matter_update_by_client_clus_illumstat_attr = false;
+    m_matter_update_by_client_clus_lightq_attr = false;
+    memset(m_illuminance_statistics, 0, sizeof(m_illuminance_statistics));
+    memset(&m_flicker_result, 0, sizeof(m_flicker_result));
+    m_light_source_class = 0;
+    m_color_temperature = 0;
 }
 
 
@@ -24,6 +33,54 @@ bool CLightSensor::matter_init_endpoint()
 
 bool CLightSensor::matter_config_attributes()
 {
+    if (!matter_create_clus_illumstat())
+        return false;
+    return matter_create_clus_lightq();
+}
+
+bool CLightSensor::matter_create_clus_illumstat()
+{
+    esp_matter::cluster_t *cluster = esp_matter::cluster::create(m_endpoint, CLUSTER_ID_ILLUMINANCE_STATISTICS, esp_matter::CLUSTER_FLAG_SERVER);
+    if (!cluster) {
+        GetLogger(eLogType::Error)->Log("Failed to create Illuminance Statistics cluster");
+        return false;
+    }
+    esp_matter::cluster::global::attribute::create_cluster_revision(cluster, 1);
+    esp_matter::cluster::global::attribute::create_feature_map(cluster, 0);
+
+    for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+        uint32_t base = i * ATTR_ID_ILLUMSTAT_WINDOW_STRIDE;
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_WINDOW_DURATION, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_SAMPLE_COUNT, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_MIN_VALUE, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_MAX_VALUE, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_MEAN_VALUE, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_TIME_WEIGHTED_MEAN, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_VARIANCE, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_ILLUMSTAT_INTEGRAL, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+    }
+
+    return true;
+}
+
+bool CLightSensor::matter_create_clus_lightq()
+{
+    esp_matter::cluster_t *cluster = esp_matter::cluster::create(m_endpoint, CLUSTER_ID_LIGHT_QUALITY, esp_matter::CLUSTER_FLAG_SERVER);
+    if (!cluster) {
+        GetLogger(eLogType::Error)->Log("Failed to create Light Quality cluster");
+        return false;
+    }
+    esp_matter::cluster::global::attribute::create_cluster_revision(cluster, 1);
+    esp_matter::cluster::global::attribute::create_feature_map(cluster, 0);
+
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_PERCENT_MODULATION, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_FLICKER_INDEX, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_MAINS_FLICKER_FREQUENCY, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint16(0));
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_MAINS_FLICKER_MODULATION, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_float(0.f));
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_UNSUPPORTED_MAINS_BINS, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_bitmap8(0));
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_LIGHT_SOURCE_CLASS, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_enum8(0));
+    esp_matter::attribute::create(cluster, ATTR_ID_LIGHTQ_COLOR_TEMPERATURE, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint16(0));
+
     return true;
 }
 
@@ -85,6 +142,9 @@ void CLightSensor::matter_on_change_attribute_value(esp_matter::attribute::callb
 void CLightSensor::matter_update_all_attribute_values()
 {
     matter_update_clus_illummeas_attr_measureval();
+    matter_update_clus_illumstat_attr_all();
+    matter_update_clus_lightq_attr_flicker();
+    matter_update_clus_lightq_attr_source();
 }
 
 void CLightSensor::update_measured_value_illuminance(uint16_t value)
@@ -97,6 +157,58 @@ void CLightSensor::update_measured_value_illuminance(uint16_t value)
     m_measured_value_illuminance_prev = m_measured_value_illuminance;
 }
 
+void CLightSensor::update_illuminance_statistics(const statistics_result_t *results, int count)
+{
+    if (!results)
+        return;
+    for (int i = 0; i < count && i < STAT_WINDOW_COUNT; i++) {
+        m_illuminance_statistics[i] = results[i];
+    }
+    matter_update_clus_illumstat_attr_all();
+}
+
+void CLightSensor::update_flicker_result(const flicker_result_t *result)
+{
+    if (!result)
+        return;
+    m_flicker_result = *result;
+    GetLogger(eLogType::Info)->Log("Update flicker result (modulation: %.1f %%, index: %.3f, mains: %u Hz %.1f %%)",
+        result->percent_modulation, result->flicker_index, result->mains_frequency, result->mains_modulation);
+    const char *bin_name[FLICKER_BIN_COUNT] = {"100Hz", "120Hz", "50Hz", "60Hz"};
+    for (int i = 0; i < FLICKER_BIN_COUNT; i++) {
+        if (result->unsupported_bins & (1 << i)) {
+            GetLoggerM(eLogType::Info)->Log("%s: unsupported", bin_name[i]);
+        } else {
+            GetLoggerM(eLogType::Info)->Log("%s: %.1f %%", bin_name[i], result->bin_modulation[i]);
+        }
+    }
+    matter_update_clus_lightq_attr_flicker();
+}
+
+void CLightSensor::update_light_source(uint8_t source_class, uint16_t color_temperature)
+{
+    bool changed = false;
+
+    // source class is already debounced by the driver (same class as the lux factor of the sample)
+    if (source_class != m_light_source_class) {
+        m_light_source_class = source_class;
+        changed = true;
+    }
+
+    // color temperature deadband around the reported value (unknown <-> known is always reported)
+    int deadband = MAX(CCT_DEADBAND_K, (int)m_color_temperature * CCT_DEADBAND_PERCENT / 100);
+    if (changed || (color_temperature == 0) != (m_color_temperature == 0) || abs((int)color_temperature - (int)m_color_temperature) >= deadband) {
+        if (color_temperature != m_color_temperature) {
+            m_color_temperature = color_temperature;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        matter_update_clus_lightq_attr_source();
+    }
+}
+
 void CLightSensor::matter_update_clus_illummeas_attr_measureval(bool force_update/*=false*/)
 {
     esp_matter_attr_val_t target_value = esp_matter_nullable_uint16(m_measured_value_illuminance);
@@ -108,4 +220,79 @@ void CLightSensor::matter_update_clus_illummeas_attr_measureval(bool force_updat
         &m_matter_update_by_client_clus_illummeas_attr_measureval,
         force_update
     );
+}
+
+void CLightSensor::matter_update_clus_illumstat_attr_all(bool force_update/*=false*/)
+{
+    for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+        statistics_result_t *stat = &m_illuminance_statistics[i];
+        uint32_t base = i * ATTR_ID_ILLUMSTAT_WINDOW_STRIDE;
+        const struct {
+            uint32_t attribute_id;
+            esp_matter_attr_val_t value;
+        } items[] = {
+            {base + ATTR_ID_ILLUMSTAT_WINDOW_DURATION, esp_matter_uint32(stat->window_sec)},
+            {base + ATTR_ID_ILLUMSTAT_SAMPLE_COUNT, esp_matter_uint32(stat->count)},
+            {base + ATTR_ID_ILLUMSTAT_MIN_VALUE, esp_matter_float(stat->min)},
+            {base + ATTR_ID_ILLUMSTAT_MAX_VALUE, esp_matter_float(stat->max)},
+            {base + ATTR_ID_ILLUMSTAT_MEAN_VALUE, esp_matter_float(stat->mean)},
+            {base + ATTR_ID_ILLUMSTAT_TIME_WEIGHTED_MEAN, esp_matter_float(stat->time_weighted_mean)},
+            {base + ATTR_ID_ILLUMSTAT_VARIANCE, esp_matter_float(stat->variance)},
+            {base + ATTR_ID_ILLUMSTAT_INTEGRAL, esp_matter_float(stat->integral)},
+        };
+        for (auto & item : items) {
+            matter_update_cluster_attribute_common(
+                m_endpoint_id,
+                CLUSTER_ID_ILLUMINANCE_STATISTICS,
+                item.attribute_id,
+                item.value,
+                &m_matter_update_by_client_clus_illumstat_attr,
+                force_update
+            );
+        }
+    }
+}
+
+void CLightSensor::matter_update_clus_lightq_attr_flicker(bool force_update/*=false*/)
+{
+    const struct {
+        uint32_t attribute_id;
+        esp_matter_attr_val_t value;
+    } items[] = {
+        {ATTR_ID_LIGHTQ_PERCENT_MODULATION, esp_matter_float(m_flicker_result.percent_modulation)},
+        {ATTR_ID_LIGHTQ_FLICKER_INDEX, esp_matter_float(m_flicker_result.flicker_index)},
+        {ATTR_ID_LIGHTQ_MAINS_FLICKER_FREQUENCY, esp_matter_uint16(m_flicker_result.mains_frequency)},
+        {ATTR_ID_LIGHTQ_MAINS_FLICKER_MODULATION, esp_matter_float(m_flicker_result.mains_modulation)},
+        {ATTR_ID_LIGHTQ_UNSUPPORTED_MAINS_BINS, esp_matter_bitmap8(m_flicker_result.unsupported_bins)},
+    };
+    for (auto & item : items) {
+        matter_update_cluster_attribute_common(
+            m_endpoint_id,
+            CLUSTER_ID_LIGHT_QUALITY,
+            item.attribute_id,
+            item.value,
+            &m_matter_update_by_client_clus_lightq_attr,
+            force_update
+        );
+    }
+}
+
+void CLightSensor::matter_update_clus_lightq_attr_source(bool force_update/*=false*/)
+{
+    matter_update_cluster_attribute_common(
+        m_endpoint_id,
+        CLUSTER_ID_LIGHT_QUALITY,
+        ATTR_ID_LIGHTQ_LIGHT_SOURCE_CLASS,
+        esp_matter_enum8(m_light_source_class),
+        &m_matter_update_by_client_clus_lightq_attr,
+        force_update
+    );
+    matter_update_cluster_attribute_common(
+        m_endpoint_id,
+        CLUSTER_ID_LIGHT_QUALITY,
+        ATTR_ID_LIGHTQ_COLOR_TEMPERATURE,
+        esp_matter_uint16(m_color_temperature),
+        &m_matter_update_by_client_clus_lightq_attr,
+        force_update
+    );
 }
\ No newline at end of file
@@ -1,6 +1,22 @@
 #include "I2CMaster.h"
 #include "driver/i2c.h"
+#include "driver/gpio.h"
 #include "logger.h"
+#include "powermanager.h"
+#include "metrics.h"
+#include "trace.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "definition.h"
+#include <string.h>
+
+#define BUS_CLEAR_HALF_PERIOD_US    5   // 100 kHz
+
+static const char *transfer_type_name[I2CTransferTypeCount] = {
+    "write",
+    "read",
+    "write and read"
+};
 
 CI2CMaster* CI2CMaster::_instance = nullptr;
 
@@ -8,6 +24,12 @@ CI2CMaster::CI2CMaster()
 {
     m_initialized = false;
     m_port = 0;
+    m_gpio_scl = -1;
+    m_gpio_sda = -1;
+    m_clk_speed = 0;
+    m_mutex = xSemaphoreCreateMutex();
+    m_spinlock = portMUX_INITIALIZER_UNLOCKED;
+    memset(m_breakers, 0, sizeof(m_breakers));
 }
 
 CI2CMaster::~CI2CMaster()
@@ -25,18 +47,30 @@ CI2CMaster* CI2CMaster::Instance()
 
 bool CI2CMaster::initialize(int port, int gpio_scl, int gpio_sda, uint32_t clk_speed)
 {
-    esp_err_t ret;
-    
     m_initialized = false;
-
     m_port = port;
+    m_gpio_scl = gpio_scl;
+    m_gpio_sda = gpio_sda;
+    m_clk_speed = clk_speed;
+
+    if (!install_driver())
+        return false;
+
+    m_initialized = true;
+    GetLogger(eLogType::Info)->Log("Initialized (port num: %d, gpio scl: %d, gpio sda: %d, clock: %u)", m_port, gpio_scl, gpio_sda, clk_speed);
+    return true;
+}
+
+bool CI2CMaster::install_driver()
+{
+    esp_err_t ret;
     i2c_config_t i2c_conf;
     i2c_conf.mode = I2C_MODE_MASTER;
-    i2c_conf.sda_io_num = gpio_sda;
-    i2c_conf.scl_io_num = gpio_scl;
+    i2c_conf.sda_io_num = m_gpio_sda;
+    i2c_conf.scl_io_num = m_gpio_scl;
     i2c_conf.sda_pullup_en = GPIO_PULLUP_ENABLE,
     i2c_conf.scl_pullup_en = GPIO_PULLUP_ENABLE,
-    i2c_conf.master.clk_speed = clk_speed,
+    i2c_conf.master.clk_speed = m_clk_speed,
     i2c_conf.clk_flags = 0;
 
     ret = i2c_param_config((i2c_port_t)m_port, &i2c_conf);
@@ -49,8 +83,7 @@ bool CI2CMaster::initialize(int port, int gpio_scl, int gpio_sda, uint32_t clk_s
         GetLogger(eLogType::Error)->Log("Failed to install i2c driver (ret: %d)", ret);
         return false;
     }
-    m_initialized = true;
-    GetLogger(eLogType::Info)->Log("Initialized (port num: %d, gpio scl: %d, gpio sda: %d, clock: %u)", m_port, gpio_scl, gpio_sda, clk_speed);
+
     return true;
 }
 
@@ -69,72 +102,297 @@ bool CI2CMaster::release()
     return true;
 }
 
-bool CI2CMaster::write_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms/*=1000*/)
+bool CI2CMaster::write_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms/*=I2C_TRANSFER_TIMEOUT_MS*/)
+{
+    TRACE_SCOPE("i2c_write");
+    return transfer(I2CWrite, dev_addr, data, data_len, nullptr, 0, timeout_ms);
+}
+
+bool CI2CMaster::read_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms/*=I2C_TRANSFER_TIMEOUT_MS*/)
+{
+    TRACE_SCOPE("i2c_read");
+    return transfer(I2CRead, dev_addr, nullptr, 0, data, data_len, timeout_ms);
+}
+
+bool CI2CMaster::write_and_read_bytes(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms/*=I2C_TRANSFER_TIMEOUT_MS*/)
+{
+    TRACE_SCOPE("i2c_write_read");
+    return transfer(I2CWriteRead, dev_addr, data_write, data_write_len, data_read, data_read_len, timeout_ms);
+}
+
+bool CI2CMaster::transfer(eI2CTransferType type, uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms)
 {
     if (!m_initialized) {
         GetLogger(eLogType::Error)->Log("Not initialized");
         return false;
     }
+    if (!breaker_allow(dev_addr)) {
+        GetMetrics()->increment(MetricI2CBreakerRejected);
+        return false;
+    }
 
-    esp_err_t ret;
-    ret = i2c_master_write_to_device(
-        (i2c_port_t)m_port, 
-        dev_addr, 
-        data, 
-        data_len, 
-        timeout_ms / portTICK_PERIOD_MS
-    );
+    CPmLockGuard pm_lock(I2CTransaction);
+    esp_err_t ret = ESP_FAIL;
+    uint32_t backoff_ms = I2C_RETRY_BACKOFF_MS;
+    for (int attempt = 0; attempt <= I2C_RETRY_COUNT; attempt++) {
+        if (attempt > 0) {
+            GetMetrics()->increment(MetricI2CRetry);
+            vTaskDelay(MAX(pdMS_TO_TICKS(backoff_ms), 1));
+            backoff_ms *= 2;
+        }
+
+        xSemaphoreTake(m_mutex, portMAX_DELAY);
+        int64_t start_us = esp_timer_get_time();
+        ret = transfer_once(type, dev_addr, data_write, data_write_len, data_read, data_read_len, timeout_ms);
+        update_metrics(ret == ESP_OK, start_us);
+        // timeout (bus busy) or sda held low by a slave stuck in the middle of a byte
+        if (ret == ESP_ERR_TIMEOUT || (ret != ESP_OK && gpio_get_level((gpio_num_t)m_gpio_sda) == 0)) {
+            clear_bus();
+        }
+        xSemaphoreGive(m_mutex);
+
+        if (ret == ESP_OK || ret == ESP_ERR_INVALID_ARG)
+            break;
+    }
+
+    breaker_update(dev_addr, ret == ESP_OK);
     if (ret != ESP_OK) {
-        GetLogger(eLogType::Error)->Log("Failed to write (ret: %d)", ret);
+        GetLogger(eLogType::Error)->Log("Failed to %s (addr: 0x%02X, ret: %d)", transfer_type_name[type], dev_addr, ret);
         return false;
     }
 
     return true;
 }
 
-bool CI2CMaster::read_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms/*=1000*/)
+esp_err_t CI2CMaster::transfer_once(eI2CTransferType type, uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms)
 {
-    if (!m_initialized) {
-        GetLogger(eLogType::Error)->Log("Not initialized");
-        return false;
+    TickType_t ticks = MAX(pdMS_TO_TICKS(timeout_ms), 1);
+    switch (type) {
+    case I2CWrite:
+        return i2c_master_write_to_device((i2c_port_t)m_port, dev_addr, data_write, data_write_len, ticks);
+    case I2CRead:
+        return i2c_master_read_from_device((i2c_port_t)m_port, dev_addr, data_read, data_read_len, ticks);
+    case I2CWriteRead:
+        return i2c_master_write_read_device((i2c_port_t)m_port, dev_addr, data_write, data_write_len, data_read, data_read_len, ticks);
+    default:
+        return ESP_ERR_INVALID_ARG;
     }
+}
 
-    esp_err_t ret;
-    ret = i2c_master_read_from_device(
-        (i2c_port_t)m_port, 
-        dev_addr, 
-        data, 
-        data_len, 
-        timeout_ms / portTICK_PERIOD_MS
-    );
-    if (ret != ESP_OK) {
-        GetLogger(eLogType::Error)->Log("Failed to read (ret: %d)", ret);
+bool CI2CMaster::probe(uint8_t dev_addr)
+{
+    if (!m_initialized)
         return false;
-    }
 
-    return true;
+    // address only write, acknowledged by a present device
+    uint8_t buffer[I2C_LINK_RECOMMENDED_SIZE(1)] = {0};
+    CPmLockGuard pm_lock(I2CTransaction);
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(buffer, sizeof(buffer));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (dev_addr << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_stop(cmd);
+    esp_err_t ret = i2c_master_cmd_begin((i2c_port_t)m_port, cmd, MAX(pdMS_TO_TICKS(I2C_PROBE_TIMEOUT_MS), 1));
+    i2c_cmd_link_delete_static(cmd);
+    xSemaphoreGive(m_mutex);
+
+    return ret == ESP_OK;
 }
 
-bool CI2CMaster::write_and_read_bytes(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms/*=1000*/)
+bool CI2CMaster::probe_read(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len)
 {
-    if (!m_initialized) {
-        GetLogger(eLogType::Error)->Log("Not initialized");
+    if (!m_initialized)
         return false;
-    }
 
-    esp_err_t ret;
-    ret = i2c_master_write_read_device(
-        (i2c_port_t)m_port, 
-        dev_addr, 
-        data_write, 
-        data_write_len, 
-        data_read,
-        data_read_len, 
-        timeout_ms / portTICK_PERIOD_MS
-    );
-    if (ret != ESP_OK) {
-        GetLogger(eLogType::Error)->Log("Failed to write and read (ret: %d)", ret);
+    CPmLockGuard pm_lock(I2CTransaction);
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = transfer_once(I2CWriteRead, dev_addr, data_write, data_write_len, data_read, data_read_len, I2C_PROBE_TIMEOUT_MS);
+    update_metrics(ret == ESP_OK, start_us);
+    xSemaphoreGive(m_mutex);
+
+    return ret == ESP_OK;
+}
+
+bool CI2CMaster::recover_bus()
+{
+    if (!m_initialized)
         return false;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    bool result = clear_bus();
+    xSemaphoreGive(m_mutex);
+    return result;
+}
+
+bool CI2CMaster::clear_bus()
+{
+    // m_mutex must be held
+    gpio_num_t scl = (gpio_num_t)m_gpio_scl;
+    gpio_num_t sda = (gpio_num_t)m_gpio_sda;
+
+    i2c_driver_delete((i2c_port_t)m_port);
+    gpio_set_direction(scl, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_direction(sda, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(scl, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode(sda, GPIO_PULLUP_ONLY);
+    gpio_set_level(sda, 1);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+
+    // clock out the remaining bits (at most 9) until the slave releases sda
+    int clocks = 0;
+    while (clocks < 9 && gpio_get_level(sda) == 0) {
+        gpio_set_level(scl, 0);
+        esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+        gpio_set_level(scl, 1);
+        esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+        clocks++;
     }
-    return true;
-}
\ No newline at end of file
+    // stop condition (sda rising while scl high)
+    gpio_set_level(scl, 0);
+    esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+    gpio_set_level(sda, 0);
+    esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+    gpio_set_level(sda, 1);
+    esp_rom_delay_us(BUS_CLEAR_HALF_PERIOD_US);
+    bool released = gpio_get_level(sda) == 1 && gpio_get_level(scl) == 1;
+
+    bool result = install_driver() && released;
+    GetMetrics()->increment(MetricI2CBusRecovery);
+    TRACE_INSTANT("i2c_bus_recovery", clocks);
+    GetLogger(eLogType::Warning)->Log("Bus recovery (clocks: %d, released: %d)", clocks, released);
+    return result;
+}
+
+i2c_breaker_t* CI2CMaster::find_breaker(uint8_t dev_addr, bool allocate)
+{
+    // m_spinlock must be held
+    i2c_breaker_t *unused = nullptr;
+    for (int i = 0; i < I2C_BREAKER_SLOT_COUNT; i++) {
+        i2c_breaker_t *breaker = &m_breakers[i];
+        if (breaker->dev_addr == dev_addr && (breaker->consecutive_failures || breaker->open_ms))
+            return breaker;
+        if (!unused && !breaker->consecutive_failures && !breaker->open_ms)
+            unused = breaker;
+    }
+    if (allocate && unused) {
+        unused->dev_addr = dev_addr;
+        return unused;
+    }
+
+    return nullptr;
+}
+
+bool CI2CMaster::breaker_allow(uint8_t dev_addr)
+{
+    bool allow = true;
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&m_spinlock);
+    i2c_breaker_t *breaker = find_breaker(dev_addr, false);
+    if (breaker && breaker->open_ms) {
+        if (now_us < breaker->open_until_us) {
+            allow = false;
+        } else {
+            // half open: let this trial through, others are refused until it is decided
+            breaker->open_until_us = now_us + (int64_t)breaker->open_ms * 1000;
+        }
+    }
+    portEXIT_CRITICAL(&m_spinlock);
+
+    return allow;
+}
+
+void CI2CMaster::breaker_update(uint8_t dev_addr, bool success)
+{
+    bool opened = false;
+    bool closed = false;
+    uint32_t open_ms = 0;
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&m_spinlock);
+    i2c_breaker_t *breaker = find_breaker(dev_addr, !success);
+    if (breaker) {
+        if (success) {
+            closed = breaker->open_ms != 0;
+            breaker->consecutive_failures = 0;
+            breaker->open_ms = 0;
+        } else if (breaker->open_ms) {
+            // failed trial
+            breaker->open_ms = MIN(breaker->open_ms * 2, (uint32_t)I2C_BREAKER_OPEN_MAX_MS);
+            breaker->open_until_us = now_us + (int64_t)breaker->open_ms * 1000;
+            open_ms = breaker->open_ms;
+        } else if (++breaker->consecutive_failures >= I2C_BREAKER_THRESHOLD) {
+            breaker->open_ms = I2C_BREAKER_OPEN_MS;
+            breaker->open_until_us = now_us + (int64_t)breaker->open_ms * 1000;
+            open_ms = breaker->open_ms;
+            opened = true;
+        }
+    }
+    portEXIT_CRITICAL(&m_spinlock);
+
+    if (opened) {
+        GetMetrics()->increment(MetricI2CBreakerOpen);
+        GetLogger(eLogType::Warning)->Log("Device 0x%02X not responding, circuit opened (%u ms)", dev_addr, open_ms);
+    } else if (open_ms) {
+        GetLogger(eLogType::Warning)->Log("Device 0x%02X still not responding, circuit reopened (%u ms)", dev_addr, open_ms);
+    } else if (closed) {
+        GetLogger(eLogType::Info)->Log("Device 0x%02X recovered, circuit closed", dev_addr);
+    }
+}
+
+bool CI2CMaster::is_device_available(uint8_t dev_addr)
+{
+    bool available = true;
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&m_spinlock);
+    i2c_breaker_t *breaker = find_breaker(dev_addr, false);
+    if (breaker && breaker->open_ms && now_us < breaker->open_until_us) {
+        available = false;
+    }
+    portEXIT_CRITICAL(&m_spinlock);
+
+    return available;
+}
+
+void CI2CMaster::reset_breakers()
+{
+    portENTER_CRITICAL(&m_spinlock);
+    memset(m_breakers, 0, sizeof(m_breakers));
+    portEXIT_CRITICAL(&m_spinlock);
+}
+
+void CI2CMaster::print_info()
+{
+    i2c_breaker_t breakers[I2C_BREAKER_SLOT_COUNT];
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&m_spinlock);
+    memcpy(breakers, m_breakers, sizeof(breakers));
+    portEXIT_CRITICAL(&m_spinlock);
+
+    GetLogger(eLogType::Info)->Log("I2C Info (port: %d, scl: %d, sda: %d, sda level: %d, scl level: %d)",
+        m_port, m_gpio_scl, m_gpio_sda, gpio_get_level((gpio_num_t)m_gpio_sda), gpio_get_level((gpio_num_t)m_gpio_scl));
+    for (int i = 0; i < I2C_BREAKER_SLOT_COUNT; i++) {
+        i2c_breaker_t *breaker = &breakers[i];
+        if (breaker->open_ms) {
+            int64_t remain_ms = MAX(breaker->open_until_us - now_us, 0) / 1000;
+            GetLoggerM(eLogType::Info)->Log("0x%02X: open (period: %u ms, trial in %lld ms)", breaker->dev_addr, breaker->open_ms, remain_ms);
+        } else if (breaker->consecutive_failures) {
+            GetLoggerM(eLogType::Info)->Log("0x%02X: closed (consecutive failures: %u)", breaker->dev_addr, breaker->consecutive_failures);
+        }
+    }
+    GetLoggerM(eLogType::Info)->Log("transactions: %u, errors: %u, retries: %u, bus recoveries: %u, breaker open: %u, rejected: %u",
+        GetMetrics()->get_counter(MetricI2CTransaction), GetMetrics()->get_counter(MetricI2CError), GetMetrics()->get_counter(MetricI2CRetry),
+        GetMetrics()->get_counter(MetricI2CBusRecovery), GetMetrics()->get_counter(MetricI2CBreakerOpen), GetMetrics()->get_counter(MetricI2CBreakerRejected));
+}
+
+void CI2CMaster::update_metrics(bool success, int64_t start_us)
+{
+    GetMetrics()->increment(MetricI2CTransaction);
+    GetMetrics()->record(MetricI2CLatency, (uint32_t)(esp_timer_get_time() - start_us));
+    if (!success) {
+        GetMetrics()->increment(MetricI2CError);
+    }
+}
@@ -0,0 +1,189 @@
+#include "calibration.h"
+#include "logger.h"
+#include "settings.h"
+#include <string.h>
+
+CLuxCalibration* CLuxCalibration::_instance = nullptr;
+
+CLuxCalibration::CLuxCalibration()
+{
+    m_revision = 0;
+    reset();
+}
+
+CLuxCalibration::~CLuxCalibration()
+{
+}
+
+CLuxCalibration* CLuxCalibration::Instance()
+{
+    if (!_instance) {
+        _instance = new CLuxCalibration();
+    }
+
+    return _instance;
+}
+
+void CLuxCalibration::set_default(calibration_data_t *data)
+{
+    memset(data, 0, sizeof(calibration_data_t));
+    data->version = CALIB_VERSION;
+    data->table_size = 0;
+    data->gain = 1.f;
+    data->offset = 0.f;
+    data->glass_transmittance = 1.f;
+    data->dark_offset = 0.f;
+}
+
+void CLuxCalibration::reset()
+{
+    set_default(&m_data);
+    build_segments();
+}
+
+bool CLuxCalibration::load()
+{
+    // settings store must be initialized before
+    calibration_data_t data;
+    GetSettings()->get_calibration(&data);
+    if (!validate(&data)) {
+        GetLogger(eLogType::Warning)->Log("Invalid calibration data, use default");
+        reset();
+        return false;
+    }
+
+    m_data = data;
+    build_segments();
+    GetLogger(eLogType::Info)->Log("Calibration loaded (gain: %g, offset: %g, glass: %g, dark: %g, table: %u)",
+        m_data.gain, m_data.offset, m_data.glass_transmittance, m_data.dark_offset, m_data.table_size);
+    return true;
+}
+
+bool CLuxCalibration::save()
+{
+    // committed to flash by the settings store (debounced)
+    return GetSettings()->set_calibration(&m_data);
+}
+
+bool CLuxCalibration::validate(const calibration_data_t *data)
+{
+    if (data->version != CALIB_VERSION || data->table_size > CALIB_TABLE_SIZE)
+        return false;
+    if (data->gain <= 0.f || data->glass_transmittance <= 0.f || data->glass_transmittance > 1.f)
+        return false;
+    for (uint16_t i = 1; i < data->table_size; i++) {
+        if (data->table_in[i] <= data->table_in[i - 1])
+            return false;
+    }
+
+    return true;
+}
+
+void CLuxCalibration::build_segments()
+{
+    // single writer: built into the inactive table, published with the revision
+    uint32_t revision = m_revision.load(std::memory_order_relaxed) + 1;
+    segment_table_t *table = &m_tables[revision & 1];
+
+    // x' = (x - dark) * k + offset, k = gain / transmittance
+    float k = m_data.gain / m_data.glass_transmittance;
+    float c = m_data.offset - m_data.dark_offset * k;
+
+    if (m_data.table_size < 2) {
+        table->segments[0].start = 0.f;
+        table->segments[0].slope = k;
+        table->segments[0].intercept = c;
+        table->count = 1;
+    } else {
+        // table(x') is linear between points and extrapolated with the first / last slope
+        table->count = 0;
+        for (uint16_t i = 0; i + 1 < m_data.table_size; i++) {
+            float in0 = m_data.table_in[i];
+            float in1 = m_data.table_in[i + 1];
+            float out0 = m_data.table_out[i];
+            float out1 = m_data.table_out[i + 1];
+            float table_slope = (out1 - out0) / (in1 - in0);
+            segment_t *seg = &table->segments[table->count++];
+            seg->start = i == 0 ? 0.f : (in0 - c) / k;
+            seg->slope = table_slope * k;
+            seg->intercept = out0 + table_slope * (c - in0);
+        }
+    }
+    m_revision.store(revision, std::memory_order_release);
+}
+
+float CLuxCalibration::apply(float lux_linear)
+{
+    uint32_t revision;
+    float lux;
+    do {
+        revision = m_revision.load(std::memory_order_acquire);
+        const segment_table_t *table = &m_tables[revision & 1];
+        // count is bounded even when the table is being rebuilt (result is discarded then)
+        int count = table->count;
+        if (count < 1 || count > CALIB_TABLE_SIZE + 1)
+            count = 1;
+
+        // binary search of the segment (segment count <= CALIB_TABLE_SIZE)
+        int lo = 0;
+        int hi = count - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (lux_linear >= table->segments[mid].start)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        lux = table->segments[lo].slope * lux_linear + table->segments[lo].intercept;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (m_revision.load(std::memory_order_relaxed) != revision);
+
+    return lux > 0.f ? lux : 0.f;
+}
+
+bool CLuxCalibration::set_coefficients(float gain, float offset, float glass_transmittance)
+{
+    if (gain <= 0.f || glass_transmittance <= 0.f || glass_transmittance > 1.f)
+        return false;
+    m_data.gain = gain;
+    m_data.offset = offset;
+    m_data.glass_transmittance = glass_transmittance;
+    build_segments();
+    return true;
+}
+
+bool CLuxCalibration::set_dark_offset(float dark_offset)
+{
+    if (dark_offset < 0.f)
+        return false;
+    m_data.dark_offset = dark_offset;
+    build_segments();
+    return true;
+}
+
+bool CLuxCalibration::set_table(const float *table_in, const float *table_out, uint16_t size)
+{
+    if (size > CALIB_TABLE_SIZE || (size > 0 && (!table_in || !table_out)))
+        return false;
+    for (uint16_t i = 1; i < size; i++) {
+        if (table_in[i] <= table_in[i - 1])
+            return false;
+    }
+    for (uint16_t i = 0; i < size; i++) {
+        m_data.table_in[i] = table_in[i];
+        m_data.table_out[i] = table_out[i];
+    }
+    m_data.table_size = size;
+    build_segments();
+    return true;
+}
+
+void CLuxCalibration::print_info()
+{
+    GetLogger(eLogType::Info)->Log("Calibration Info");
+    GetLoggerM(eLogType::Info)->Log("Gain: %g, Offset: %g lux, Glass Transmittance: %g, Dark Offset: %g lux",
+        m_data.gain, m_data.offset, m_data.glass_transmittance, m_data.dark_offset);
+    for (uint16_t i = 0; i < m_data.table_size; i++) {
+        GetLoggerM(eLogType::Info)->Log("Table[%u]: %g -> %g", i, m_data.table_in[i], m_data.table_out[i]);
+    }
+}
@@ -0,0 +1,94 @@
+#include "luxcorrection.h"
+#include "veml7700reg.h"
+#include <array>
+#include <stddef.h>
+
+#define CORRECTION_LINEAR_MAX   24576.f     // corrected value exceeds 140 klx
+#define CORRECTION_STEP_RATIO   0.03f       // knot spacing relative to x (max interpolation error ~0.14 %)
+#define CORRECTION_STEP_MIN     16.f
+
+typedef struct correction_knot {
+    float x;    // linear lux
+    float y;    // corrected lux
+} correction_knot_t;
+
+static constexpr double correction_polynomial(double x)
+{
+    return (((6.0135e-13 * x - 9.3924e-9) * x + 8.1488e-5) * x + 1.0023) * x;
+}
+
+static constexpr float next_knot(float x)
+{
+    return x + (x * CORRECTION_STEP_RATIO > CORRECTION_STEP_MIN ? x * CORRECTION_STEP_RATIO : CORRECTION_STEP_MIN);
+}
+
+static constexpr size_t count_knots()
+{
+    size_t count = 1;
+    for (float x = 0.f; x < CORRECTION_LINEAR_MAX; x = next_knot(x)) {
+        count++;
+    }
+    return count;
+}
+
+static constexpr size_t CORRECTION_KNOT_COUNT = count_knots();
+
+static constexpr std::array<correction_knot_t, CORRECTION_KNOT_COUNT> build_correction_table()
+{
+    std::array<correction_knot_t, CORRECTION_KNOT_COUNT> table{};
+    float x = 0.f;
+    for (size_t i = 0; i < CORRECTION_KNOT_COUNT; i++) {
+        table[i].x = x;
+        table[i].y = (float)correction_polynomial(x);
+        x = next_knot(x);
+    }
+    return table;
+}
+
+static constexpr std::array<correction_knot_t, CORRECTION_KNOT_COUNT> correction_table = build_correction_table();
+
+static constexpr bool is_table_monotonic()
+{
+    for (size_t i = 1; i < CORRECTION_KNOT_COUNT; i++) {
+        if (correction_table[i].x <= correction_table[i - 1].x || correction_table[i].y <= correction_table[i - 1].y)
+            return false;
+    }
+    return true;
+}
+
+static_assert(is_table_monotonic(), "correction table must be strictly increasing");
+static_assert(correction_table[0].x == 0.f && correction_table[0].y == 0.f, "correction table must start at origin");
+static_assert(correction_table[CORRECTION_KNOT_COUNT - 1].y >= 140000.f, "correction table must cover 140 klx");
+
+bool lux_correction_required(uint8_t gain, uint8_t integ_time, uint16_t raw)
+{
+    (void)integ_time;
+    if (raw == 0)
+        return false;
+    return gain == VEML7700_GAIN_1_8 || gain == VEML7700_GAIN_1_4;
+}
+
+float lux_correction_apply(float lux_linear)
+{
+    if (lux_linear <= 0.f)
+        return 0.f;
+
+    // binary search of the segment [lo, lo + 1]
+    size_t lo = 0;
+    size_t hi = CORRECTION_KNOT_COUNT - 1;
+    if (lux_linear >= correction_table[hi].x) {
+        lo = hi - 1;
+    } else {
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (lux_linear >= correction_table[mid].x)
+                lo = mid;
+            else
+                hi = mid;
+        }
+    }
+
+    const correction_knot_t &k0 = correction_table[lo];
+    const correction_knot_t &k1 = correction_table[lo + 1];
+    return k0.y + (lux_linear - k0.x) * (k1.y - k0.y) / (k1.x - k0.x);
+}
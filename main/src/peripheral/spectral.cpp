@@ -0,0 +1,138 @@
+#include "spectral.h"
+#include <stddef.h>
+
+#define SPECTRAL_MIN_WHITE_COUNT    100     // below this ratio is dominated by noise
+#define SPECTRAL_HYSTERESIS_RATIO   0.03f   // boundaries of the current class are widened by this ratio
+
+typedef struct spectral_model_entry {
+    float ratio_max;            // upper bound of ALS / WHITE ratio
+    eLightSourceClass source;
+    uint16_t cct_low;           // cct at lower bound of ratio range
+    uint16_t cct_high;          // cct at upper bound of ratio range
+    float lux_factor;
+} spectral_model_entry_t;
+
+/*
+ * compact lookup model (ascending ratio)
+ * IR rich sources raise WHITE channel response relative to ALS channel;
+ * values are approximate and should be refined with reference measurements
+ */
+static const spectral_model_entry_t spectral_model[] = {
+    {0.45f, LightSourceIncandescent, 2200, 3200, 0.95f},
+    {0.70f, LightSourceDaylight, 4000, 6500, 1.00f},
+    {0.85f, LightSourceFluorescent, 3000, 5000, 1.00f},
+    {2.00f, LightSourceLED, 2700, 6000, 1.02f},
+};
+
+#define SPECTRAL_MODEL_COUNT    (sizeof(spectral_model) / sizeof(spectral_model[0]))
+
+static float entry_ratio_min(size_t idx)
+{
+    return idx ? spectral_model[idx - 1].ratio_max : 0.f;
+}
+
+static uint16_t entry_cct(size_t idx, float ratio)
+{
+    const spectral_model_entry_t &entry = spectral_model[idx];
+    float ratio_min = entry_ratio_min(idx);
+    float t = (ratio - ratio_min) / (entry.ratio_max - ratio_min);
+    // ratio may be in the hysteresis band outside of the entry
+    t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+    return (uint16_t)((float)entry.cct_low + t * (float)(entry.cct_high - entry.cct_low));
+}
+
+eLightSourceClass estimate_light_source(uint16_t als_raw, uint16_t white_raw, uint16_t *cct)
+{
+    if (cct)
+        *cct = 0;
+    if (white_raw < SPECTRAL_MIN_WHITE_COUNT)
+        return LightSourceUnknown;
+
+    float ratio = (float)als_raw / (float)white_raw;
+    for (size_t i = 0; i < SPECTRAL_MODEL_COUNT; i++) {
+        if (ratio <= spectral_model[i].ratio_max) {
+            if (cct) {
+                *cct = entry_cct(i, ratio);
+            }
+            return spectral_model[i].source;
+        }
+    }
+
+    return LightSourceUnknown;
+}
+
+CLightSourceTracker::CLightSourceTracker()
+{
+    reset();
+}
+
+void CLightSourceTracker::reset()
+{
+    m_source = LightSourceUnknown;
+    m_cct = 0;
+    m_pending_source = LightSourceUnknown;
+    m_pending_count = 0;
+}
+
+eLightSourceClass CLightSourceTracker::update(uint16_t als_raw, uint16_t white_raw, uint16_t *cct)
+{
+    uint16_t estimated_cct = 0;
+    eLightSourceClass source = estimate_light_source(als_raw, white_raw, &estimated_cct);
+
+    // still the current class while the ratio is within its widened boundaries
+    if (source != m_source && m_source != LightSourceUnknown && white_raw >= SPECTRAL_MIN_WHITE_COUNT) {
+        float ratio = (float)als_raw / (float)white_raw;
+        for (size_t i = 0; i < SPECTRAL_MODEL_COUNT; i++) {
+            if (spectral_model[i].source != m_source)
+                continue;
+            if (ratio >= entry_ratio_min(i) - SPECTRAL_HYSTERESIS_RATIO && ratio <= spectral_model[i].ratio_max + SPECTRAL_HYSTERESIS_RATIO) {
+                source = m_source;
+                estimated_cct = entry_cct(i, ratio);
+            }
+            break;
+        }
+    }
+
+    if (source == m_source || m_source == LightSourceUnknown) {
+        // first known class is taken at once (nothing to flip against)
+        m_source = source;
+        m_cct = estimated_cct;
+        m_pending_count = 0;
+    } else {
+        if (source != m_pending_source) {
+            m_pending_source = source;
+            m_pending_count = 0;
+        }
+        if (++m_pending_count >= LIGHT_SOURCE_DEBOUNCE_COUNT) {
+            m_source = source;
+            m_cct = estimated_cct;
+            m_pending_count = 0;
+        }
+    }
+
+    // cct of the current class (kept while a new class is pending)
+    if (cct)
+        *cct = m_cct;
+    return m_source;
+}
+
+float get_light_source_lux_factor(eLightSourceClass source)
+{
+    for (auto & entry : spectral_model) {
+        if (entry.source == source)
+            return entry.lux_factor;
+    }
+
+    return 1.f;
+}
+
+const char* get_light_source_name(eLightSourceClass source)
+{
+    switch (source) {
+    case LightSourceIncandescent: return "Incandescent";
+    case LightSourceDaylight: return "Daylight";
+    case LightSourceFluorescent: return "Fluorescent";
+    case LightSourceLED: return "LED";
+    default: return "Unknown";
+    }
+}
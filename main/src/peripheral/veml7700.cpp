@@ -1,52 +1,76 @@
 #include "veml7700.h"
+#include "veml7700reg.h"
 #include "logger.h"
+#include "powermanager.h"
+#include "calibration.h"
+#include "spectral.h"
+#include "luxcorrection.h"
+#include "metrics.h"
+#include "trace.h"
+#include "definition.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
 #include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
 
-#define VEML7700_I2CADDR_DEFAULT    0x10    /**< I2C address */
-
-#define VEML7700_ALS_CONFIG         0x00    /**< Light configuration register */
-#define VEML7700_ALS_THREHOLD_HIGH  0x01    /**< Light high threshold for irq */
-#define VEML7700_ALS_THREHOLD_LOW   0x02    /**< Light low threshold for irq */
-#define VEML7700_ALS_POWER_SAVE     0x03    /**< Power save regiester */
-#define VEML7700_ALS_DATA           0x04    /**< The light data output */
-#define VEML7700_WHITE_DATA         0x05    /**< The white light data output */
-#define VEML7700_INTERRUPTSTATUS    0x06    /**< What IRQ (if any) */
-#define VEML7700_DEVICE_ID          0x07    /**< Device ID */
-
-#define VEML7700_INTERRUPT_HIGH     0x4000  /**< Interrupt status for high threshold */
-#define VEML7700_INTERRUPT_LOW      0x8000  /**< Interrupt status for low threshold */
-
-#define VEML7700_GAIN_1             0x00    /**< ALS gain 1x */
-#define VEML7700_GAIN_2             0x01    /**< ALS gain 2x */
-#define VEML7700_GAIN_1_8           0x02    /**< ALS gain 1/8x */
-#define VEML7700_GAIN_1_4           0x03    /**< ALS gain 1/4x */
-
-#define VEML7700_IT_100MS           0x00    /**< ALS intetgration time 100ms */
-#define VEML7700_IT_200MS           0x01    /**< ALS intetgration time 200ms */
-#define VEML7700_IT_400MS           0x02    /**< ALS intetgration time 400ms */
-#define VEML7700_IT_800MS           0x03    /**< ALS intetgration time 800ms */
-#define VEML7700_IT_50MS            0x08    /**< ALS intetgration time 50ms */
-#define VEML7700_IT_25MS            0x0C    /**< ALS intetgration time 25ms */
-
-#define VEML7700_PERS_1             0x00    /**< ALS irq persistence 1 sample */
-#define VEML7700_PERS_2             0x01    /**< ALS irq persistence 2 samples */
-#define VEML7700_PERS_4             0x02    /**< ALS irq persistence 4 samples */
-#define VEML7700_PERS_8             0x03    /**< ALS irq persistence 8 samples */
-
-#define VEML7700_POWERSAVE_MODE1    0x00    /**< Power saving mode 1 */
-#define VEML7700_POWERSAVE_MODE2    0x01    /**< Power saving mode 2 */
-#define VEML7700_POWERSAVE_MODE3    0x02    /**< Power saving mode 3 */
-#define VEML7700_POWERSAVE_MODE4    0x03    /**< Power saving mode 4 */
+#define TASK_BURST_STACK_DEPTH      3072
+#define TASK_BURST_PRIORITY         CONFIG_APP_BUS_TASK_PRIORITY
 
 CVeml7700Ctrl* CVeml7700Ctrl::_instance = nullptr;
+static RTC_NOINIT_ATTR veml7700_retained_state_t s_retained_state;
+
+// auto ranging table (index 0: least sensitive)
+#define RANGE_GAIN_COUNT        4
+#define RANGE_INTEG_TIME_COUNT  6
+static const uint8_t range_gain_table[RANGE_GAIN_COUNT] = {VEML7700_GAIN_1_8, VEML7700_GAIN_1_4, VEML7700_GAIN_1, VEML7700_GAIN_2};
+static const uint8_t range_integ_time_table[RANGE_INTEG_TIME_COUNT] = {VEML7700_IT_25MS, VEML7700_IT_50MS, VEML7700_IT_100MS, VEML7700_IT_200MS, VEML7700_IT_400MS, VEML7700_IT_800MS};
+
+static float real_integration_time(uint8_t val);
+
+static int integ_time_index(uint8_t val)
+{
+    switch (val) {
+    case VEML7700_IT_25MS: return 0;
+    case VEML7700_IT_50MS: return 1;
+    case VEML7700_IT_100MS: return 2;
+    case VEML7700_IT_200MS: return 3;
+    case VEML7700_IT_400MS: return 4;
+    case VEML7700_IT_800MS: return 5;
+    default: return -1;
+    }
+}
 
 CVeml7700Ctrl::CVeml7700Ctrl()
 {
     m_i2c_master = nullptr;
     m_config_reg_val = 0;
     m_pwr_save_reg_val = 0;
+    m_mutex = xSemaphoreCreateMutex();
+    m_ranging_policy = RangingAuto;
+    m_fixed_gain = VEML7700_GAIN_1_8;
+    m_fixed_integ_time = VEML7700_IT_100MS;
+    m_pending_ranging = 0;
+    m_pending_power_saving = 0;
+    driver_reset_ranging_statistics();
+    m_dev_id = 0;
+    m_warm_started = false;
+    m_resume_gain_idx = -1;
+    m_resume_integ_idx = -1;
+    m_burst_running = false;
+    m_burst_task_handle = nullptr;
+    m_burst_gain = VEML7700_GAIN_1_8;
+    m_burst_integ_time = VEML7700_IT_25MS;
+    m_burst_sample_count = 0;
+    m_burst_period_us = 25000;
+    m_burst_triggered = false;
+    m_burst_head = 0;
+    m_burst_tail = 0;
+    m_burst_overrun_count = 0;
 }
 
 CVeml7700Ctrl::~CVeml7700Ctrl()
@@ -62,76 +86,241 @@ CVeml7700Ctrl* CVeml7700Ctrl::Instance()
     return _instance;
 }
 
-bool CVeml7700Ctrl::initialize(CI2CMaster *i2c_master)
+bool CVeml7700Ctrl::driver_initialize(CI2CMaster *i2c_master)
 {
     m_i2c_master = i2c_master;
+    m_light_source.reset();
 
     uint16_t dev_id_value = 0;
     if (read_device_id(&dev_id_value)) {
-        GetLogger(eLogType::Info)->Log("Slave address option code: 0x%02X, Device ID Code: 0x%02X", (uint8_t)(dev_id_value >> 8), (uint8_t)(dev_id_value & 0xFF));
+        m_dev_id = dev_id_value;
+        GetLogger(eLogType::Info)->Log("Slave address option code: 0x%02X, Device ID Code: 0x%02X", veml7700_id_addr_option_t::get(dev_id_value), veml7700_id_code_t::get(dev_id_value));
     } else {
         return false;
     }
 
-    // initialize register value to member variables
-    read_configure_register(&m_config_reg_val);
-    read_power_saving_register(&m_pwr_save_reg_val);
+    if (restore_retained_state(dev_id_value)) {
+        // sensor kept running with the retained configuration, no register writes
+        GetLogger(eLogType::Info)->Log("Initialized (warm start, last lux: %g)", s_retained_state.lux);
+        return true;
+    }
 
-    // initialize IC
-    shutdown();
-    set_enable_interrupt(false);
-    set_als_persistence(VEML7700_PERS_1);
-    set_gain(VEML7700_GAIN_1_8);
-    set_als_integration_time(VEML7700_IT_100MS);
-    set_power_saving_mode(false);
-    power_on();
+    // initialize IC: whole registers are written (no read-modify-write), configuration is changed while shut down
+    // (gain 1/8, integration time 100ms, persistence 1, interrupt disabled)
+    m_config_reg_val = veml7700_als_gain_t::encode(VEML7700_GAIN_1_8) | veml7700_als_it_t::encode(VEML7700_IT_100MS)
+        | veml7700_als_pers_t::encode(VEML7700_PERS_1) | veml7700_als_sd_t::encode(1);
+    m_pwr_save_reg_val = veml7700_psm_t::encode(VEML7700_POWERSAVE_MODE1);   // power saving disabled
+    if (!write_configure_register(m_config_reg_val) || !write_power_saving_register(m_pwr_save_reg_val) || !power_on()) {
+        GetLogger(eLogType::Error)->Log("Failed to configure");
+        return false;
+    }
 
     GetLogger(eLogType::Info)->Log("Initialized");
     return true;
 }
 
-bool CVeml7700Ctrl::release()
+bool CVeml7700Ctrl::driver_release()
 {
+    stop_burst();
     shutdown();
+    invalidate_retained_state();
+    return true;
+}
+
+void CVeml7700Ctrl::driver_detach()
+{
+    // no shutdown: writes to an absent device only fail after retries and open the bus breaker
+    stop_burst();
+    invalidate_retained_state();
+    m_warm_started = false;
+    m_resume_gain_idx = -1;
+    m_light_source.reset();
+}
+
+static uint32_t retained_state_checksum(const veml7700_retained_state_t *state)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(veml7700_retained_state_t, checksum));
+}
+
+bool CVeml7700Ctrl::restore_retained_state(uint16_t dev_id)
+{
+    // only the first initialization after reset may find the sensor still configured (hot-plugged sensor is power cycled)
+    static bool first_initialize = true;
+    if (!first_initialize) {
+        invalidate_retained_state();
+        return false;
+    }
+    first_initialize = false;
+
+    // rtc slow memory (and the sensor power) survives only these resets
+    switch (esp_reset_reason()) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_DEEPSLEEP:
+        break;
+    default:
+        invalidate_retained_state();
+        return false;
+    }
+
+    veml7700_retained_state_t state = s_retained_state;
+    if (state.magic != VEML7700_RETAINED_MAGIC || state.checksum != retained_state_checksum(&state) || state.dev_id != dev_id) {
+        invalidate_retained_state();
+        return false;
+    }
+    int it_idx = integ_time_index(state.integ_time);
+    if (state.gain > VEML7700_GAIN_1_4 || it_idx < 0 || veml7700_als_sd_t::get(state.config_reg_val)) {
+        invalidate_retained_state();
+        return false;
+    }
+
+    const int gain_idx_table[] = {2, 3, 0, 1};  // gain register value -> auto ranging gain index
+    m_config_reg_val = state.config_reg_val;
+    m_pwr_save_reg_val = state.pwr_save_reg_val;
+    m_resume_gain_idx = gain_idx_table[state.gain];
+    m_resume_integ_idx = it_idx;
+    m_warm_started = true;
     return true;
 }
 
-bool CVeml7700Ctrl::read_measurement(float *result)
+void CVeml7700Ctrl::save_retained_state(uint8_t gain, uint8_t integ_time, float lux)
+{
+    veml7700_retained_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.magic = VEML7700_RETAINED_MAGIC;
+    state.dev_id = m_dev_id;
+    state.config_reg_val = m_config_reg_val;
+    state.pwr_save_reg_val = m_pwr_save_reg_val;
+    state.gain = gain;
+    state.integ_time = integ_time;
+    state.lux = lux;
+    state.checksum = retained_state_checksum(&state);
+    s_retained_state = state;
+}
+
+void CVeml7700Ctrl::invalidate_retained_state()
+{
+    s_retained_state.magic = 0;
+}
+
+bool CVeml7700Ctrl::get_retained_lux(float *lux)
 {
-    /* Automatically adjust gain and integration time to obtain goot result */
-    const uint8_t gain_word_array[] = {VEML7700_GAIN_1_8, VEML7700_GAIN_1_4, VEML7700_GAIN_1, VEML7700_GAIN_2};
-    const uint8_t integ_time_word_array[] = {VEML7700_IT_25MS, VEML7700_IT_50MS, VEML7700_IT_100MS, VEML7700_IT_200MS, VEML7700_IT_400MS, VEML7700_IT_800MS};
+    if (!m_warm_started || !lux)
+        return false;
+    *lux = s_retained_state.lux;
+    return true;
+}
 
-    int gain_idx = 0;
-    int integ_idx = 2;
+bool CVeml7700Ctrl::driver_read_measurement(light_sample_t *sample)
+{
+    if (m_burst_running)
+        return false;
+    TRACE_SCOPE("veml_read_measurement");
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    if (m_burst_running) {
+        // burst started while waiting for its sample lock: gain and integration time belong to the burst
+        GetMetrics()->increment(MetricSampleFailed);
+        xSemaphoreGive(m_mutex);
+        return false;
+    }
+    apply_pending_settings();
+    int64_t start_us = esp_timer_get_time();
+    uint32_t ranging_steps = 0;
     uint16_t als_value = 0;
-    bool correction = false;
-
-    set_gain(gain_word_array[gain_idx]);
-    set_als_integration_time(integ_time_word_array[integ_idx]);
-    read_als_high_resolution_output_data(&als_value);
-
-    if (als_value <= 100) {
-        while ((als_value <= 100) && !((gain_idx == 3) && (integ_idx == 5))) {
-            if (gain_idx < 3) {
-                set_gain(gain_word_array[++gain_idx]);
-            } else if (integ_idx < 5) {
-                set_als_integration_time(integ_time_word_array[++integ_idx]);
-            }
-            read_als_high_resolution_output_data(&als_value);
-        }
+    uint16_t white_value = 0;
+    // any i2c failure (after transport retries) aborts the measurement, nothing is published
+    bool ok;
+    if (m_ranging_policy == RangingFixed) {
+        // no ranging and no saturation recovery (clipped samples are still annotated)
+        ok = set_gain(m_fixed_gain)
+            && set_als_integration_time(m_fixed_integ_time)
+            && read_raw(&als_value)
+            && read_raw_aux(&white_value);
     } else {
-        correction = true;
-        while ((als_value > 10000) && (integ_idx > 0)) {
-            set_als_integration_time(integ_time_word_array[--integ_idx]);
-            read_als_high_resolution_output_data(&als_value);
+        /* Automatically adjust gain and integration time to obtain goot result */
+        light_range_t range = {0, 2};   // gain 1/8, 100ms
+        if (m_resume_gain_idx >= 0) {
+            // warm restart: sensor is already converting with the last good configuration
+            range.gain_idx = m_resume_gain_idx;
+            range.integ_idx = m_resume_integ_idx;
+            m_resume_gain_idx = -1;
         }
+        ok = auto_range(&range, &als_value, &white_value, &ranging_steps);
+    }
+    GetMetrics()->increment(MetricRangingSteps, ranging_steps);
+    if (!ok) {
+        GetMetrics()->increment(MetricSampleFailed);
+        xSemaphoreGive(m_mutex);
+        return false;
+    }
+
+    uint8_t gain = 0, integ_time = 0;
+    get_gain(&gain);
+    get_als_integration_time(&integ_time);
+    bool clipped = is_saturated(als_value, white_value);
+    GetMetrics()->increment(MetricSampleCount);
+    if (clipped) {
+        GetMetrics()->increment(MetricClippedSamples);
+    }
+    int it_idx = integ_time_index(integ_time);
+    if (gain < 4 && it_idx >= 0) {
+        m_ranging_usage[gain][it_idx]++;
     }
+    uint16_t cct = 0;
+    // debounced class: lux factor and published class change together, not sample by sample
+    eLightSourceClass source = m_light_source.update(als_value, white_value, &cct);
 
     // calculation 
-    if (result)
-        *result = convert_raw_to_lux(als_value, correction);
+    float lux = convert_raw_to_lux(als_value, gain, integ_time, get_light_source_lux_factor(source));
+    if (sample) {
+        sample->lux = lux;
+        sample->raw = als_value;
+        sample->raw_aux = white_value;
+        sample->gain = gain;
+        sample->integ_time = integ_time;
+        sample->conversion_ms = (uint16_t)real_integration_time(integ_time);
+        sample->source_class = (uint8_t)source;
+        sample->color_temperature = cct;
+        sample->clipped = clipped;
+    }
+    if (!clipped) {
+        save_retained_state(gain, integ_time, lux);
+    }
+    GetMetrics()->record(MetricSampleLatency, (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+    xSemaphoreGive(m_mutex);
+
+    return true;
+}
+
+bool CVeml7700Ctrl::range_apply(const light_range_t &range)
+{
+    // gain and integration time in a single register write (conversion restarts)
+    m_config_reg_val = veml7700_als_gain_t::set(m_config_reg_val, range_gain_table[range.gain_idx]);
+    m_config_reg_val = veml7700_als_it_t::set(m_config_reg_val, range_integ_time_table[range.integ_idx]);
+    return write_configure_register(m_config_reg_val);
+}
+
+bool CVeml7700Ctrl::range_up(light_range_t *range)
+{
+    // gain first (no extra conversion time), then integration time
+    if (range->gain_idx < RANGE_GAIN_COUNT - 1) {
+        range->gain_idx++;
+    } else if (range->integ_idx < RANGE_INTEG_TIME_COUNT - 1) {
+        range->integ_idx++;
+    } else {
+        return false;
+    }
+    return true;
+}
 
+bool CVeml7700Ctrl::range_down(light_range_t *range)
+{
+    if (range->integ_idx <= 0)
+        return false;
+    range->integ_idx--;
     return true;
 }
 
@@ -166,6 +355,13 @@ static float real_integration_time(uint8_t val)
     return real_value;
 }
 
+static float real_power_saving_wait(uint8_t mode)
+{
+    // refresh time = integration time + power saving mode wait time
+    const float wait_ms[] = {500.f, 1000.f, 2000.f, 4000.f};
+    return wait_ms[mode & 0x03];
+}
+
 static float real_gain(uint8_t val)
 {
     float real_value;
@@ -191,34 +387,330 @@ static float real_gain(uint8_t val)
     return real_value;
 }
 
-float CVeml7700Ctrl::convert_raw_to_lux(uint16_t raw, bool correction)
+static float raw_to_corrected_lux(float raw, uint8_t gain, uint8_t integ_time)
 {
-    uint8_t integ_time_raw, gain_raw;
-    
-    get_als_integration_time(&integ_time_raw);
-    get_gain(&gain_raw);
-    
-    float integ_time_val = real_integration_time(integ_time_raw);
-    float gain_val = real_gain(gain_raw);
+    float integ_time_val = real_integration_time(integ_time);
+    float gain_val = real_gain(gain);
+    if (integ_time_val < 0 || gain_val < 0)
+        return 0.f;
 
     float resolution = 0.0036f * (800.f / integ_time_val) * (2.f / gain_val);
-    float calc = (float)raw * resolution;
-    if (correction) {
-        calc = (((6.0135e-13 * calc - 9.3924e-9) * calc + 8.1488e-5) * calc + 1.0023) * calc;
+    float calc = raw * resolution;
+    // decided by the gain / integration time the raw value was actually taken with
+    if (lux_correction_required(gain, integ_time, (uint16_t)raw)) {
+        calc = lux_correction_apply(calc);
     }
 
     return calc;
 }
 
+bool CVeml7700Ctrl::is_saturated(uint16_t als, uint16_t white)
+{
+    // WHITE has wider spectral response, so it pins first under broadband (sun) light
+    return als >= VEML7700_SATURATION_COUNT || white >= VEML7700_SATURATION_COUNT;
+}
+
+float CVeml7700Ctrl::convert_raw_to_lux(uint16_t raw, uint8_t gain, uint8_t integ_time, float source_factor/*=1.f*/)
+{
+    return GetLuxCalibration()->apply(raw_to_corrected_lux((float)raw, gain, integ_time) * source_factor);
+}
+
+bool CVeml7700Ctrl::driver_set_ranging_policy(eRangingPolicy policy, uint8_t fixed_gain, uint8_t fixed_integ_time)
+{
+    if (policy >= RangingPolicyCount || real_gain(fixed_gain) < 0 || real_integration_time(fixed_integ_time) < 0) {
+        GetLogger(eLogType::Error)->Log("Invalid ranging policy (%d, gain: %u, integration time: %u)", policy, fixed_gain, fixed_integ_time);
+        return false;
+    }
+
+    m_pending_ranging.store(PendingValid | ((uint32_t)policy << 16) | ((uint32_t)fixed_gain << 8) | fixed_integ_time, std::memory_order_release);
+    return try_apply_pending_settings();
+}
+
+bool CVeml7700Ctrl::driver_set_power_saving(bool enable, uint8_t mode)
+{
+    if (mode > VEML7700_POWERSAVE_MODE4)
+        return false;
+
+    m_pending_power_saving.store(PendingValid | ((uint32_t)enable << 8) | mode, std::memory_order_release);
+    return try_apply_pending_settings();
+}
+
+bool CVeml7700Ctrl::try_apply_pending_settings()
+{
+    // console never waits for the sensor: a running burst or measurement applies the settings when it is done
+    if (m_burst_running || xSemaphoreTake(m_mutex, 0) != pdTRUE) {
+        GetLogger(eLogType::Info)->Log("Sensor is busy, settings are applied from the next measurement");
+        return true;
+    }
+    bool result = apply_pending_settings();
+    xSemaphoreGive(m_mutex);
+    return result;
+}
+
+bool CVeml7700Ctrl::apply_pending_settings()
+{
+    // m_mutex is held by the caller
+    bool result = true;
+    uint32_t ranging = m_pending_ranging.exchange(0, std::memory_order_acquire);
+    if (ranging & PendingValid) {
+        m_ranging_policy = (eRangingPolicy)((ranging >> 16) & 0xFF);
+        m_fixed_gain = (uint8_t)(ranging >> 8);
+        m_fixed_integ_time = (uint8_t)ranging;
+    }
+    uint32_t power_saving = m_pending_power_saving.exchange(0, std::memory_order_acquire);
+    if (power_saving & PendingValid) {
+        result = set_power_saving_mode((uint8_t)(power_saving & 0xFF)) && set_enable_power_saving((power_saving >> 8) & 1);
+        if (!result) {
+            GetLogger(eLogType::Error)->Log("Failed to apply power saving mode");
+        }
+    }
+    return result;
+}
+
+void CVeml7700Ctrl::driver_print_ranging_statistics()
+{
+    const char *gain_name[] = {"1", "2", "1/8", "1/4"};
+    const int integ_time_ms[] = {25, 50, 100, 200, 400, 800};
+
+    GetLogger(eLogType::Info)->Log("Ranging Statistics (policy: %s)", m_ranging_policy == RangingFixed ? "fixed" : "auto");
+    for (int g = 0; g < 4; g++) {
+        for (int i = 0; i < 6; i++) {
+            if (m_ranging_usage[g][i]) {
+                GetLoggerM(eLogType::Info)->Log("gain %s, %d ms: %u samples", gain_name[g], integ_time_ms[i], m_ranging_usage[g][i]);
+            }
+        }
+    }
+}
+
+void CVeml7700Ctrl::driver_reset_ranging_statistics()
+{
+    for (int g = 0; g < 4; g++) {
+        for (int i = 0; i < 6; i++) {
+            m_ranging_usage[g][i] = 0;
+        }
+    }
+}
+
+bool CVeml7700Ctrl::start_burst(uint8_t gain, uint8_t integ_time, uint32_t sample_count/*=0*/, uint32_t period_us/*=0*/)
+{
+    float integ_time_val = real_integration_time(integ_time);
+    float gain_val = real_gain(gain);
+    if (integ_time_val < 0 || gain_val < 0) {
+        GetLogger(eLogType::Error)->Log("Invalid gain (%u) or integration time (%u)", gain, integ_time);
+        return false;
+    }
+    uint32_t integ_time_us = (uint32_t)integ_time_val * 1000;
+    if (period_us && period_us < integ_time_us) {
+        GetLogger(eLogType::Error)->Log("Burst period (%u us) is shorter than integration time", period_us);
+        return false;
+    }
+    if (m_burst_running || m_burst_task_handle) {
+        GetLogger(eLogType::Warning)->Log("Burst is already running");
+        return false;
+    }
+
+    m_burst_gain = gain;
+    m_burst_integ_time = integ_time;
+    m_burst_sample_count = sample_count;
+    m_burst_period_us = period_us ? period_us : integ_time_us;
+    m_burst_triggered = m_burst_period_us > integ_time_us;
+    m_burst_head = 0;
+    m_burst_tail = 0;
+    m_burst_overrun_count = 0;
+    m_burst_running = true;
+    if (xTaskCreatePinnedToCore(task_burst_function, "TASK_BURST", TASK_BURST_STACK_DEPTH, this, TASK_BURST_PRIORITY, &m_burst_task_handle, TASK_SENSOR_CORE_ID) != pdPASS) {
+        GetLogger(eLogType::Error)->Log("Failed to create burst task");
+        m_burst_running = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool CVeml7700Ctrl::stop_burst()
+{
+    // burst task terminates itself at the next period
+    m_burst_running = false;
+    return true;
+}
+
+float CVeml7700Ctrl::get_burst_sample_rate()
+{
+    return 1e6f / (float)m_burst_period_us;
+}
+
+size_t CVeml7700Ctrl::get_burst_available()
+{
+    return m_burst_head.load(std::memory_order_acquire) - m_burst_tail.load(std::memory_order_relaxed);
+}
+
+size_t CVeml7700Ctrl::read_burst_block(veml7700_burst_sample_t *samples, size_t max_count, uint16_t decimation/*=1*/)
+{
+    if (!samples || decimation == 0)
+        return 0;
+
+    uint32_t head = m_burst_head.load(std::memory_order_acquire);
+    uint32_t tail = m_burst_tail.load(std::memory_order_relaxed);
+    size_t count = 0;
+    while (count < max_count && head - tail >= decimation) {
+        uint32_t raw_sum = 0;
+        bool clipped = false;
+        for (uint16_t i = 0; i < decimation; i++) {
+            raw_sum += m_burst_buffer[(tail + i) % VEML7700_BURST_BUFFER_SIZE].raw;
+            clipped |= m_burst_buffer[(tail + i) % VEML7700_BURST_BUFFER_SIZE].clipped;
+        }
+        veml7700_burst_sample_t *sample = &samples[count++];
+        sample->timestamp_us = m_burst_buffer[(tail + decimation - 1) % VEML7700_BURST_BUFFER_SIZE].timestamp_us;
+        sample->raw = (uint16_t)(raw_sum / decimation);
+        sample->clipped = clipped;
+        sample->lux = GetLuxCalibration()->apply(raw_to_corrected_lux((float)raw_sum / (float)decimation, m_burst_gain, m_burst_integ_time));
+        tail += decimation;
+    }
+    m_burst_tail.store(tail, std::memory_order_release);
+
+    return count;
+}
+
+void CVeml7700Ctrl::burst_timer_callback(void *arg)
+{
+    xTaskNotifyGive(static_cast<TaskHandle_t>(arg));
+}
+
+void CVeml7700Ctrl::task_burst_function(void *param)
+{
+    CVeml7700Ctrl *obj = static_cast<CVeml7700Ctrl *>(param);
+    uint32_t sample_index = 0;
+    uint16_t raw = 0;
+    // sample clock from esp_timer (tick rounding would put mains aliases on DC / nyquist),
+    // light sleep wake-up latency would add timing jitter (not a guard: vTaskDelete does not return)
+    GetPowerManager()->acquire(SensorIntegration);
+    esp_timer_handle_t timer = nullptr;
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = burst_timer_callback;
+    timer_args.arg = xTaskGetCurrentTaskHandle();
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "veml_burst";
+    if (esp_timer_create(&timer_args, &timer) != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to create burst timer");
+        obj->m_burst_running = false;
+    }
+
+    // m_mutex only around register access (not for the whole burst): measurement task skips its samples while
+    // m_burst_running, console settings are deferred, so a long burst never blocks them
+    TRACE_INSTANT("veml_burst_start", obj->m_burst_sample_count);
+    // lock gain and integration time, wait for the first complete conversion
+    xSemaphoreTake(obj->m_mutex, portMAX_DELAY);
+    bool configured = obj->m_burst_running && obj->set_gain(obj->m_burst_gain) && obj->set_als_integration_time(obj->m_burst_integ_time);
+    xSemaphoreGive(obj->m_mutex);
+    if (configured) {
+        obj->wait_for_read_measurement();
+        GetLogger(eLogType::Info)->Log("Burst started (%.2f Hz%s, samples: %u)", obj->get_burst_sample_rate(),
+            obj->m_burst_triggered ? ", triggered" : "", obj->m_burst_sample_count);
+        esp_timer_start_periodic(timer, obj->m_burst_period_us);
+    } else {
+        obj->m_burst_running = false;
+    }
+
+    while (obj->m_burst_running) {
+        xSemaphoreTake(obj->m_mutex, portMAX_DELAY);
+        bool ok = obj->read_register_common(veml7700_reg_als_t::code, &raw);
+        if (ok && obj->m_burst_triggered) {
+            // restart the conversion: integration window starts at a fixed offset from this sample
+            obj->write_configure_register(obj->m_config_reg_val);
+        }
+        xSemaphoreGive(obj->m_mutex);
+        if (!ok) {
+            // transport already retried (or device circuit is open)
+            GetLogger(eLogType::Error)->Log("Burst aborted (i2c failure)");
+            break;
+        }
+        uint32_t head = obj->m_burst_head.load(std::memory_order_relaxed);
+        uint32_t tail = obj->m_burst_tail.load(std::memory_order_acquire);
+        if (head - tail < VEML7700_BURST_BUFFER_SIZE) {
+            veml7700_burst_sample_t *sample = &obj->m_burst_buffer[head % VEML7700_BURST_BUFFER_SIZE];
+            sample->timestamp_us = esp_timer_get_time();
+            sample->raw = raw;
+            sample->clipped = raw >= VEML7700_SATURATION_COUNT;
+            sample->lux = obj->convert_raw_to_lux(raw, obj->m_burst_gain, obj->m_burst_integ_time);
+            obj->m_burst_head.store(head + 1, std::memory_order_release);
+        } else {
+            obj->m_burst_overrun_count++;
+            GetMetrics()->increment(MetricBurstOverrun);
+        }
+        if (obj->m_burst_sample_count && ++sample_index >= obj->m_burst_sample_count)
+            break;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    if (timer) {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+    }
+    GetPowerManager()->release(SensorIntegration);
+
+    GetLogger(eLogType::Info)->Log("Burst terminated (samples: %u, overrun: %u)", sample_index, obj->m_burst_overrun_count);
+    obj->m_burst_running = false;
+    // settings deferred during the burst
+    xSemaphoreTake(obj->m_mutex, portMAX_DELAY);
+    obj->apply_pending_settings();
+    xSemaphoreGive(obj->m_mutex);
+    obj->m_burst_task_handle = nullptr;
+    vTaskDelete(nullptr);
+}
+
+bool CVeml7700Ctrl::capture_dark_offset(float *dark_lux, int sample_count/*=4*/)
+{
+    if (m_burst_running || sample_count <= 0)
+        return false;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    if (m_burst_running) {
+        xSemaphoreGive(m_mutex);
+        return false;
+    }
+    uint16_t config_reg_backup = m_config_reg_val;
+    uint32_t raw_sum = 0;
+    uint16_t raw = 0;
+
+    // restart conversion at the most sensitive setting
+    bool ok = shutdown()
+        && set_gain(VEML7700_GAIN_2)
+        && set_als_integration_time(VEML7700_IT_800MS)
+        && power_on();
+    vTaskDelay(pdMS_TO_TICKS(5));   // wait time after power on (> 2.5ms)
+    for (int i = 0; ok && i < sample_count; i++) {
+        wait_for_read_measurement();
+        ok = read_register_common(veml7700_reg_als_t::code, &raw);
+        raw_sum += raw;
+    }
+
+    shutdown();
+    m_config_reg_val = veml7700_als_sd_t::set(config_reg_backup, 1);
+    write_configure_register(m_config_reg_val);
+    power_on();
+    xSemaphoreGive(m_mutex);
+    if (!ok) {
+        GetLogger(eLogType::Error)->Log("Failed to capture dark offset (i2c failure)");
+        return false;
+    }
+
+    // resolution at gain 2, 800ms
+    float value = 0.0036f * (float)raw_sum / (float)sample_count;
+    GetLogger(eLogType::Info)->Log("Captured dark offset: %g lux (%d samples)", value, sample_count);
+    if (dark_lux)
+        *dark_lux = value;
+
+    return true;
+}
+
 bool CVeml7700Ctrl::power_on()
 {
-    m_config_reg_val &= 0xFFFE;
+    m_config_reg_val = veml7700_als_sd_t::set(m_config_reg_val, 0);
     return write_configure_register(m_config_reg_val);
 }
 
 bool CVeml7700Ctrl::shutdown()
 {
-    m_config_reg_val |= 0x0001;
+    m_config_reg_val = veml7700_als_sd_t::set(m_config_reg_val, 1);
     return write_configure_register(m_config_reg_val);
 }
 
@@ -230,7 +722,7 @@ bool CVeml7700Ctrl::is_running(bool *running, bool read_register/*=false*/)
     }
 
     if (running) {
-        *running = !(bool)(m_config_reg_val & 0x0001);
+        *running = !veml7700_als_sd_t::get(m_config_reg_val);
     }
 
     return true;
@@ -238,10 +730,7 @@ bool CVeml7700Ctrl::is_running(bool *running, bool read_register/*=false*/)
 
 bool CVeml7700Ctrl::set_enable_interrupt(bool enable)
 {
-    if (enable)
-        m_config_reg_val |= 0x0002;
-    else
-        m_config_reg_val &= 0xFFFD;
+    m_config_reg_val = veml7700_als_int_en_t::set(m_config_reg_val, enable ? 1 : 0);
     return write_configure_register(m_config_reg_val);
 }
 
@@ -253,7 +742,7 @@ bool CVeml7700Ctrl::is_interrupt_enabled(bool *enabled, bool read_register/*=fal
     }
 
     if (enabled) {
-        *enabled = !(bool)(m_config_reg_val & 0x0002);
+        *enabled = (bool)veml7700_als_int_en_t::get(m_config_reg_val);
     }
 
     return true;
@@ -261,12 +750,11 @@ bool CVeml7700Ctrl::is_interrupt_enabled(bool *enabled, bool read_register/*=fal
 
 bool CVeml7700Ctrl::set_als_persistence(uint8_t value)
 {
-    m_config_reg_val &= 0xFFCF;
-    if (value >= 4) {
+    if (!veml7700_als_pers_t::is_valid(value)) {
         GetLogger(eLogType::Info)->Log("Exceeded value range");
         return false;
     }
-    m_config_reg_val |= (uint16_t)value << 4;
+    m_config_reg_val = veml7700_als_pers_t::set(m_config_reg_val, value);
     return write_configure_register(m_config_reg_val);
 }
 
@@ -278,7 +766,7 @@ bool CVeml7700Ctrl::get_als_persistence(uint8_t *value, bool read_register/*=fal
     }
 
     if (value) {
-        *value = (uint8_t)((m_config_reg_val & 0x0030) >> 4);
+        *value = veml7700_als_pers_t::get(m_config_reg_val);
     }
 
     return true;
@@ -286,8 +774,11 @@ bool CVeml7700Ctrl::get_als_persistence(uint8_t *value, bool read_register/*=fal
 
 bool CVeml7700Ctrl::set_als_integration_time(uint8_t value)
 {
-    m_config_reg_val &= 0xFC3F;
-    m_config_reg_val |= (uint16_t)value << 6;
+    if (!veml7700_als_it_t::is_valid(value)) {
+        GetLogger(eLogType::Info)->Log("Exceeded value range");
+        return false;
+    }
+    m_config_reg_val = veml7700_als_it_t::set(m_config_reg_val, value);
     return write_configure_register(m_config_reg_val);
 }
 
@@ -299,7 +790,7 @@ bool CVeml7700Ctrl::get_als_integration_time(uint8_t *value, bool read_register/
     }
 
     if (value) {
-        *value = (uint8_t)((m_config_reg_val & 0x03C0) >> 6);
+        *value = veml7700_als_it_t::get(m_config_reg_val);
     }
 
     return true;
@@ -307,12 +798,11 @@ bool CVeml7700Ctrl::get_als_integration_time(uint8_t *value, bool read_register/
 
 bool CVeml7700Ctrl::set_gain(uint8_t value)
 {
-    m_config_reg_val &= 0xE7FF;
-    if (value >= 4) {
+    if (!veml7700_als_gain_t::is_valid(value)) {
         GetLogger(eLogType::Info)->Log("Exceeded value range");
         return false;
     }
-    m_config_reg_val |= (uint16_t)value << 11;
+    m_config_reg_val = veml7700_als_gain_t::set(m_config_reg_val, value);
     return write_configure_register(m_config_reg_val);
 }
 
@@ -324,7 +814,7 @@ bool CVeml7700Ctrl::get_gain(uint8_t *value, bool read_register/*=false*/)
     }
 
     if (value) {
-        *value = (uint8_t)((m_config_reg_val & 0x1800) >> 11);
+        *value = veml7700_als_gain_t::get(m_config_reg_val);
     }
 
     return true;
@@ -332,10 +822,7 @@ bool CVeml7700Ctrl::get_gain(uint8_t *value, bool read_register/*=false*/)
 
 bool CVeml7700Ctrl::set_enable_power_saving(bool enable)
 {
-    if (enable)
-        m_pwr_save_reg_val |= 0x0001;
-    else
-        m_pwr_save_reg_val &= 0xFFFE;
+    m_pwr_save_reg_val = veml7700_psm_en_t::set(m_pwr_save_reg_val, enable ? 1 : 0);
     return write_power_saving_register(m_pwr_save_reg_val);
 }
 
@@ -347,7 +834,7 @@ bool CVeml7700Ctrl::is_power_saving_enabled(bool *enable, bool read_register/*=f
     }
 
     if (enable) {
-        *enable = (bool)(m_pwr_save_reg_val & 0x0001);
+        *enable = (bool)veml7700_psm_en_t::get(m_pwr_save_reg_val);
     }
 
     return true;
@@ -355,8 +842,11 @@ bool CVeml7700Ctrl::is_power_saving_enabled(bool *enable, bool read_register/*=f
 
 bool CVeml7700Ctrl::set_power_saving_mode(uint8_t value)
 {
-    m_pwr_save_reg_val &= 0xFFF9;
-    m_pwr_save_reg_val |= (uint16_t)value << 1;
+    if (!veml7700_psm_t::is_valid(value)) {
+        GetLogger(eLogType::Info)->Log("Exceeded value range");
+        return false;
+    }
+    m_pwr_save_reg_val = veml7700_psm_t::set(m_pwr_save_reg_val, value);
     return write_power_saving_register(m_pwr_save_reg_val);
 }
 
@@ -368,7 +858,7 @@ bool CVeml7700Ctrl::get_power_saving_mode(uint8_t *value, bool read_register/*=f
     }
 
     if (value) {
-        *value = (uint8_t)((m_pwr_save_reg_val & 0x0006) >> 1);
+        *value = veml7700_psm_t::get(m_pwr_save_reg_val);
     }
 
     return true;
@@ -413,42 +903,42 @@ bool CVeml7700Ctrl::write_register_common(uint8_t code, uint16_t value)
 
 bool CVeml7700Ctrl::read_configure_register(uint16_t *value)
 {
-    return read_register_common(VEML7700_ALS_CONFIG, value);
+    return read_register_common(veml7700_reg_als_conf_t::code, value);
 }
 
 bool CVeml7700Ctrl::write_configure_register(uint16_t value)
 {
-    return write_register_common(VEML7700_ALS_CONFIG, value);
+    return write_register_common(veml7700_reg_als_conf_t::code, value);
 }
 
 bool CVeml7700Ctrl::read_power_saving_register(uint16_t *value)
 {
-    return read_register_common(VEML7700_ALS_POWER_SAVE, value);
+    return read_register_common(veml7700_reg_power_saving_t::code, value);
 }
 
 bool CVeml7700Ctrl::write_power_saving_register(uint16_t value)
 {
-    return write_register_common(VEML7700_ALS_POWER_SAVE, value);
+    return write_register_common(veml7700_reg_power_saving_t::code, value);
 }
 
 bool CVeml7700Ctrl::read_low_threshold_window_setting(uint16_t *value)
 {
-    return read_register_common(VEML7700_ALS_THREHOLD_LOW, value);
+    return read_register_common(veml7700_reg_als_wl_t::code, value);
 }
 
 bool CVeml7700Ctrl::write_low_threshold_window_setting(uint16_t value)
 {
-    return write_register_common(VEML7700_ALS_THREHOLD_LOW, value);
+    return write_register_common(veml7700_reg_als_wl_t::code, value);
 }
 
 bool CVeml7700Ctrl::read_high_threshold_window_setting(uint16_t *value)
 {
-    return read_register_common(VEML7700_ALS_THREHOLD_HIGH, value);
+    return read_register_common(veml7700_reg_als_wh_t::code, value);
 }
 
 bool CVeml7700Ctrl::write_high_threshold_window_setting(uint16_t value)
 {
-    return write_register_common(VEML7700_ALS_THREHOLD_HIGH, value);
+    return write_register_common(veml7700_reg_als_wh_t::code, value);
 }
 
 void CVeml7700Ctrl::wait_for_read_measurement()
@@ -456,25 +946,38 @@ void CVeml7700Ctrl::wait_for_read_measurement()
     uint8_t integ_time_raw = 0;
     get_als_integration_time(&integ_time_raw);
     float integ_time_val = real_integration_time(integ_time_raw);
-    if (integ_time_val > 0)
-        vTaskDelay((uint32_t)(integ_time_val * 2) / portTICK_PERIOD_MS);
+    if (integ_time_val <= 0)
+        return;
+    // one full refresh cycle (integration time + power saving mode wait time)
+    // plus one integration time for a conversion already in progress when the configuration changed
+    float wait_ms = 2.f * integ_time_val;
+    bool power_saving = false;
+    is_power_saving_enabled(&power_saving);
+    if (power_saving) {
+        uint8_t mode = 0;
+        get_power_saving_mode(&mode);
+        wait_ms += real_power_saving_wait(mode);
+    }
+    CPmLockGuard pm_lock(SensorIntegration);
+    TRACE_SCOPE("veml_integration_wait");
+    vTaskDelay((uint32_t)wait_ms / portTICK_PERIOD_MS);
 }
 
 bool CVeml7700Ctrl::read_als_high_resolution_output_data(uint16_t *value, bool wait/*=true*/)
 {
     if (wait)
         wait_for_read_measurement();
-    return !read_register_common(VEML7700_ALS_DATA, value);
+    return read_register_common(veml7700_reg_als_t::code, value);
 }
 
 bool CVeml7700Ctrl::read_white_channel_output_data(uint16_t *value, bool wait/*=true*/)
 {
     if (wait)
         wait_for_read_measurement();
-    return read_register_common(VEML7700_WHITE_DATA, value);
+    return read_register_common(veml7700_reg_white_t::code, value);
 }
 
 bool CVeml7700Ctrl::read_device_id(uint16_t *value)
 {
-    return read_register_common(VEML7700_DEVICE_ID, value);
+    return read_register_common(veml7700_reg_id_t::code, value);
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "adaptivesampler.h"
+#include "definition.h"
+#include <math.h>
+
+CAdaptiveSampler::CAdaptiveSampler()
+{
+    reset();
+}
+
+CAdaptiveSampler::~CAdaptiveSampler()
+{
+}
+
+void CAdaptiveSampler::reset()
+{
+    m_has_last = false;
+    m_last_lux = 0.f;
+    m_noise = 0.f;
+    m_period_ms = 0;
+}
+
+uint32_t CAdaptiveSampler::update(float lux, uint32_t conversion_ms, const sampling_settings_t *settings)
+{
+    uint32_t min_period_ms = MAX(settings->min_period_ms, conversion_ms);
+    uint32_t max_period_ms = MAX(settings->max_period_ms, min_period_ms);
+    if (!m_has_last) {
+        // start fast, settles by doubling
+        m_has_last = true;
+        m_last_lux = lux;
+        m_period_ms = min_period_ms;
+        return m_period_ms;
+    }
+
+    float change = fabsf(lux - m_last_lux) / MAX(m_last_lux, ADAPTIVE_LUX_FLOOR);
+    float threshold = MAX(settings->change_percent / 100.f, ADAPTIVE_NOISE_FACTOR * m_noise);
+    if (change > ADAPTIVE_JUMP_FACTOR * threshold) {
+        // step change (light switch)
+        m_period_ms = min_period_ms;
+    } else if (change > threshold) {
+        // ramp (dimming, sunrise / sunset)
+        m_period_ms = m_period_ms / 2;
+    } else {
+        m_noise += ADAPTIVE_NOISE_ALPHA * (change - m_noise);
+        m_period_ms = m_period_ms > max_period_ms / 2 ? max_period_ms : m_period_ms * 2;
+    }
+    m_period_ms = MIN(MAX(m_period_ms, min_period_ms), max_period_ms);
+    m_last_lux = lux;
+
+    return m_period_ms;
+}
@@ -0,0 +1,78 @@
+#include "boottimeline.h"
+#include "logger.h"
+#include "esp_timer.h"
+
+static const char *phase_name[BootPhaseCount] = {
+    "nvs",
+    "power manager",
+    "settings",
+    "button",
+    "history",
+    "root node",
+    "matter start",
+    "endpoint",
+    "console",
+    "sensor init",
+    "first sample",
+    "first report"
+};
+
+CBootTimeline* CBootTimeline::_instance = nullptr;
+
+CBootTimeline::CBootTimeline()
+{
+    for (int i = 0; i < BootPhaseCount; i++) {
+        m_begin_us[i] = -1;
+        m_end_us[i] = -1;
+    }
+}
+
+CBootTimeline::~CBootTimeline()
+{
+}
+
+CBootTimeline* CBootTimeline::Instance()
+{
+    if (!_instance) {
+        _instance = new CBootTimeline();
+    }
+
+    return _instance;
+}
+
+void CBootTimeline::begin(eBootPhase phase)
+{
+    if (phase >= BootPhaseCount)
+        return;
+    m_begin_us[phase] = esp_timer_get_time();
+}
+
+void CBootTimeline::end(eBootPhase phase)
+{
+    if (phase >= BootPhaseCount || m_end_us[phase] >= 0)
+        return;
+    m_end_us[phase] = esp_timer_get_time();
+}
+
+uint32_t CBootTimeline::get_elapsed_ms(eBootPhase phase)
+{
+    if (phase >= BootPhaseCount || m_end_us[phase] < 0)
+        return 0;
+    return (uint32_t)(m_end_us[phase] / 1000);
+}
+
+void CBootTimeline::print_info()
+{
+    GetLogger(eLogType::Info)->Log("Boot Timeline (unit: ms since application start)");
+    GetLoggerM(eLogType::Info)->Log("%-14s %9s %9s %9s", "phase", "begin", "end", "duration");
+    for (int i = 0; i < BootPhaseCount; i++) {
+        if (m_end_us[i] < 0) {
+            GetLoggerM(eLogType::Info)->Log("%-14s %9s", phase_name[i], "-");
+        } else if (m_begin_us[i] < 0) {
+            GetLoggerM(eLogType::Info)->Log("%-14s %9s %9.1f", phase_name[i], "", (float)m_end_us[i] / 1000.f);
+        } else {
+            GetLoggerM(eLogType::Info)->Log("%-14s %9.1f %9.1f %9.1f", phase_name[i],
+                (float)m_begin_us[i] / 1000.f, (float)m_end_us[i] / 1000.f, (float)(m_end_us[i] - m_begin_us[i]) / 1000.f);
+        }
+    }
+}
@@ -0,0 +1,391 @@
+#include "console.h"
+#include "logger.h"
+#include "powermanager.h"
+#include "history.h"
+#include "calibration.h"
+#include "veml7700.h"
+#include "metrics.h"
+#include "trace.h"
+#include "system.h"
+#include "settings.h"
+#include "boottimeline.h"
+#include "I2CMaster.h"
+#include "discovery.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#if CONFIG_ENABLE_CHIP_SHELL
+#include <esp_matter_console.h>
+#endif
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static esp_err_t console_power_handler(int argc, char **argv)
+{
+    GetPowerManager()->print_statistics();
+    return ESP_OK;
+}
+
+static void job_history_dump(void *arg)
+{
+    CHistoryReader reader;
+    history_sample_t sample;
+    if (!reader.begin((uint32_t)(uintptr_t)arg))
+        return;
+    // boot,timestamp,value (timestamp: unix time when clock is 'E'poch, seconds since that boot when 'U'ptime)
+    while (reader.next(&sample)) {
+        printf("%u,%c%u,%g\n", sample.boot_count, (sample.flags & HISTORY_FLAG_EPOCH) ? 'E' : 'U', sample.timestamp, sample.value);
+    }
+}
+
+static esp_err_t console_history_handler(int argc, char **argv)
+{
+    if (argc >= 1 && !strcmp(argv[0], "info")) {
+        GetHistoryStore()->print_info();
+    } else if (argc >= 1 && !strcmp(argv[0], "flush")) {
+        GetHistoryStore()->flush();
+    } else if (argc >= 1 && !strcmp(argv[0], "dump")) {
+        uint32_t since = argc >= 2 ? (uint32_t)strtoul(argv[1], nullptr, 0) : 0;
+        // long uart output, run in worker task
+        if (!GetSystem()->post_job(job_history_dump, (void *)(uintptr_t)since))
+            return ESP_FAIL;
+    } else {
+        printf("Usage: matter history info|flush|dump [since_unix_time]\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t console_calib_handler(int argc, char **argv)
+{
+    CLuxCalibration *calib = GetLuxCalibration();
+    if (argc >= 1 && !strcmp(argv[0], "show")) {
+        calib->print_info();
+    } else if (argc >= 4 && !strcmp(argv[0], "set")) {
+        if (!calib->set_coefficients(strtof(argv[1], nullptr), strtof(argv[2], nullptr), strtof(argv[3], nullptr)))
+            return ESP_ERR_INVALID_ARG;
+    } else if (argc >= 1 && !strcmp(argv[0], "table")) {
+        // table in0:out0 in1:out1 ...
+        float table_in[CALIB_TABLE_SIZE];
+        float table_out[CALIB_TABLE_SIZE];
+        uint16_t size = 0;
+        for (int i = 1; i < argc && size < CALIB_TABLE_SIZE; i++) {
+            char *sep = strchr(argv[i], ':');
+            if (!sep)
+                return ESP_ERR_INVALID_ARG;
+            table_in[size] = strtof(argv[i], nullptr);
+            table_out[size] = strtof(sep + 1, nullptr);
+            size++;
+        }
+        if (!calib->set_table(table_in, table_out, size))
+            return ESP_ERR_INVALID_ARG;
+    } else if (argc >= 1 && !strcmp(argv[0], "dark")) {
+        float dark_lux;
+        if (!GetVeml7700Ctrl()->capture_dark_offset(&dark_lux) || !calib->set_dark_offset(dark_lux))
+            return ESP_FAIL;
+    } else if (argc >= 1 && !strcmp(argv[0], "save")) {
+        if (!calib->save())
+            return ESP_FAIL;
+    } else if (argc >= 1 && !strcmp(argv[0], "reset")) {
+        calib->reset();
+    } else {
+        printf("Usage: matter calib show|set <gain> <offset> <glass>|table [in:out ...]|dark|save|reset\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t console_metrics_handler(int argc, char **argv)
+{
+    if (argc == 0 || !strcmp(argv[0], "show")) {
+        GetMetrics()->print_info();
+    } else if (!strcmp(argv[0], "reset")) {
+        GetMetrics()->reset();
+    } else {
+        printf("Usage: matter metrics [show|reset]\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t console_trace_handler(int argc, char **argv)
+{
+    if (argc >= 1 && !strcmp(argv[0], "start")) {
+        GetTrace()->start();
+    } else if (argc >= 1 && !strcmp(argv[0], "stop")) {
+        GetTrace()->stop();
+    } else if (argc >= 1 && !strcmp(argv[0], "clear")) {
+        GetTrace()->clear();
+    } else if (argc >= 1 && !strcmp(argv[0], "dump")) {
+        if (!GetSystem()->post_job([](void *arg) { GetTrace()->dump(); }))
+            return ESP_FAIL;
+    } else {
+        printf("Usage: matter trace start|stop|clear|dump\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t console_diag_handler(int argc, char **argv)
+{
+    bool result = false;
+    if (argc >= 1 && !strcmp(argv[0], "info")) {
+        result = GetSystem()->post_job([](void *arg) { GetSystem()->print_system_info(); });
+    } else if (argc >= 1 && !strcmp(argv[0], "endpoints")) {
+        result = GetSystem()->post_job([](void *arg) { GetSystem()->print_matter_endpoints_info(); });
+    } else if (argc >= 1 && !strcmp(argv[0], "boot")) {
+        GetBootTimeline()->print_info();
+        result = true;
+    } else {
+        printf("Usage: matter diag info|endpoints|boot\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return result ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t console_i2c_handler(int argc, char **argv)
+{
+    if (argc == 0 || !strcmp(argv[0], "info")) {
+        GetI2CMaster()->print_info();
+    } else if (!strcmp(argv[0], "recover")) {
+        return GetI2CMaster()->recover_bus() ? ESP_OK : ESP_FAIL;
+    } else if (!strcmp(argv[0], "reset")) {
+        // close all circuit breakers
+        GetI2CMaster()->reset_breakers();
+    } else if (!strcmp(argv[0], "scan")) {
+        // probing takes a while, run on worker task
+        GetSystem()->post_job([](void *arg) { GetBusDiscovery()->print_scan(); });
+    } else {
+        printf("Usage: matter i2c [info|recover|reset|scan]\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static bool parse_gain(const char *str, uint8_t *gain)
+{
+    if (!strcmp(str, "1/8")) {
+        *gain = VEML7700_GAIN_1_8;
+    } else if (!strcmp(str, "1/4")) {
+        *gain = VEML7700_GAIN_1_4;
+    } else if (!strcmp(str, "1")) {
+        *gain = VEML7700_GAIN_1;
+    } else if (!strcmp(str, "2")) {
+        *gain = VEML7700_GAIN_2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parse_integ_time(const char *str, uint8_t *integ_time)
+{
+    switch (atoi(str)) {
+    case 25: *integ_time = VEML7700_IT_25MS; break;
+    case 50: *integ_time = VEML7700_IT_50MS; break;
+    case 100: *integ_time = VEML7700_IT_100MS; break;
+    case 200: *integ_time = VEML7700_IT_200MS; break;
+    case 400: *integ_time = VEML7700_IT_400MS; break;
+    case 800: *integ_time = VEML7700_IT_800MS; break;
+    default: return false;
+    }
+    return true;
+}
+
+#define BURST_DRAIN_BLOCK_COUNT     4       // blocks of 16 samples printed per worker job
+
+static uint32_t burst_printed_count = 0;
+
+static void job_sensor_burst_drain(void *arg)
+{
+    // prints one chunk and re-posts itself, so that other worker jobs are not blocked
+    // for the whole burst (up to 65535 samples, several minutes at 800ms integration time)
+    veml7700_burst_sample_t block[16];
+    size_t read_count = 0;
+
+    for (int n = 0; n < BURST_DRAIN_BLOCK_COUNT; n++) {
+        read_count = GetVeml7700Ctrl()->read_burst_block(block, sizeof(block) / sizeof(block[0]));
+        for (size_t i = 0; i < read_count; i++) {
+            printf("%lld,%u,%g%s\n", block[i].timestamp_us, block[i].raw, block[i].lux, block[i].clipped ? ",clipped" : "");
+        }
+        burst_printed_count += read_count;
+        if (read_count < sizeof(block) / sizeof(block[0]))
+            break;
+    }
+
+    if (GetVeml7700Ctrl()->is_burst_running() || GetVeml7700Ctrl()->get_burst_available() > 0) {
+        if (read_count == 0) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (!GetSystem()->post_job(job_sensor_burst_drain)) {
+            GetVeml7700Ctrl()->stop_burst();
+            printf("# burst aborted (%u samples)\n", burst_printed_count);
+        }
+        return;
+    }
+    printf("# burst end (%u samples, overrun: %u)\n", burst_printed_count, GetVeml7700Ctrl()->get_burst_overrun_count());
+}
+
+static void job_sensor_burst(void *arg)
+{
+    // arg: [31:16] sample count, [15:8] gain, [7:0] integration time
+    uint32_t param = (uint32_t)(uintptr_t)arg;
+    uint32_t sample_count = param >> 16;
+
+    if (!GetVeml7700Ctrl()->start_burst((param >> 8) & 0xFF, param & 0xFF, sample_count))
+        return;
+    printf("# burst begin (rate: %g Hz)\n", GetVeml7700Ctrl()->get_burst_sample_rate());
+    burst_printed_count = 0;
+    job_sensor_burst_drain(nullptr);
+}
+
+static esp_err_t console_sensor_handler(int argc, char **argv)
+{
+    sensor_settings_t settings;
+    GetSettings()->get(&settings);
+
+    if (argc == 0 || !strcmp(argv[0], "show")) {
+        GetSettings()->print_info();
+        return ESP_OK;
+    } else if (argc >= 2 && !strcmp(argv[0], "period")) {
+        settings.period_ms = (uint32_t)strtoul(argv[1], nullptr, 0);
+        sampling_settings_t sampling;
+        GetSettings()->get_sampling(&sampling);
+        if (sampling.adaptive) {
+            printf("Adaptive period is on: period is used after 'matter sensor adaptive off'\n");
+        }
+    } else if (argc >= 2 && !strcmp(argv[0], "ranging") && !strcmp(argv[1], "auto")) {
+        settings.ranging_policy = RangingAuto;
+    } else if (argc >= 4 && !strcmp(argv[0], "ranging") && !strcmp(argv[1], "fixed")) {
+        if (!parse_gain(argv[2], &settings.fixed_gain) || !parse_integ_time(argv[3], &settings.fixed_integ_time))
+            return ESP_ERR_INVALID_ARG;
+        settings.ranging_policy = RangingFixed;
+    } else if (argc >= 2 && !strcmp(argv[0], "psm")) {
+        settings.power_saving_mode = !strcmp(argv[1], "off") ? 0 : (uint8_t)atoi(argv[1]);
+    } else if (argc >= 2 && !strcmp(argv[0], "deadband")) {
+        settings.deadband_percent = strtof(argv[1], nullptr);
+    } else if (argc >= 2 && !strcmp(argv[0], "filter")) {
+        settings.filter_alpha = strtof(argv[1], nullptr);
+    } else if (argc >= 2 && !strcmp(argv[0], "adaptive")) {
+        // adaptive period has its own settings section
+        sampling_settings_t sampling;
+        GetSettings()->get_sampling(&sampling);
+        sampling.adaptive = strcmp(argv[1], "off") ? 1 : 0;
+        if (argc >= 4) {
+            sampling.min_period_ms = (uint32_t)strtoul(argv[2], nullptr, 0);
+            sampling.max_period_ms = (uint32_t)strtoul(argv[3], nullptr, 0);
+        }
+        if (argc >= 5) {
+            sampling.change_percent = strtof(argv[4], nullptr);
+        }
+        if (!GetSettings()->set_sampling(&sampling))
+            return ESP_ERR_INVALID_ARG;
+        GetSystem()->wake_measurement_task();
+        return ESP_OK;
+    } else if (argc >= 1 && !strcmp(argv[0], "default")) {
+        CSettings::set_default(&settings);
+    } else if (argc >= 1 && !strcmp(argv[0], "commit")) {
+        // write to flash now instead of waiting for the debounce period
+        return GetSettings()->commit() ? ESP_OK : ESP_FAIL;
+    } else if (argc >= 1 && !strcmp(argv[0], "stats")) {
+        if (argc >= 2 && !strcmp(argv[1], "reset")) {
+            GetLightSensorDriver()->reset_ranging_statistics();
+            GetMetrics()->reset();
+        } else {
+            GetLightSensorDriver()->print_ranging_statistics();
+            GetMetrics()->print_info();
+        }
+        return ESP_OK;
+    } else if (argc >= 4 && !strcmp(argv[0], "burst")) {
+        uint8_t gain, integ_time;
+        uint32_t sample_count = (uint32_t)strtoul(argv[3], nullptr, 0);
+        if (!parse_gain(argv[1], &gain) || !parse_integ_time(argv[2], &integ_time) || sample_count == 0 || sample_count > 0xFFFF)
+            return ESP_ERR_INVALID_ARG;
+        // sampled by the burst task, long uart output is printed by chunked worker jobs
+        uint32_t param = (sample_count << 16) | ((uint32_t)gain << 8) | integ_time;
+        return GetSystem()->post_job(job_sensor_burst, (void *)(uintptr_t)param) ? ESP_OK : ESP_FAIL;
+    } else {
+        printf("Usage: matter sensor show|period <ms> (fixed, ignored while adaptive on)|adaptive off|on [<min_ms> <max_ms> [<change_percent>]]|ranging auto|ranging fixed <gain> <it_ms>|psm off|1~4|deadband <percent>|filter <alpha>|default|commit|stats [reset]|burst <gain> <it_ms> <count>\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // applied live (measurement task reads settings every period)
+    if (!GetSettings()->set(&settings))
+        return ESP_ERR_INVALID_ARG;
+    if (!GetSystem()->apply_sensor_settings())
+        return ESP_FAIL;
+    GetSystem()->wake_measurement_task();
+    return ESP_OK;
+}
+
+static const esp_matter::console::command_t console_commands[] = {
+    {
+        .name = "power",
+        .description = "Print power management lock and mode statistics. Usage: matter power",
+        .handler = console_power_handler,
+    },
+    {
+        .name = "history",
+        .description = "Sample history store. Usage: matter history info|flush|dump [since_unix_time]",
+        .handler = console_history_handler,
+    },
+    {
+        .name = "calib",
+        .description = "Sensor calibration. Usage: matter calib show|set <gain> <offset> <glass>|table [in:out ...]|dark|save|reset",
+        .handler = console_calib_handler,
+    },
+    {
+        .name = "metrics",
+        .description = "Runtime metrics (counters, gauges, histograms). Usage: matter metrics [show|reset]",
+        .handler = console_metrics_handler,
+    },
+    {
+        .name = "trace",
+        .description = "Event tracing (convert dump with scripts/trace2chrome.py). Usage: matter trace start|stop|clear|dump",
+        .handler = console_trace_handler,
+    },
+    {
+        .name = "diag",
+        .description = "Print system information, matter data model (same as button single / double click) or boot phase timeline. Usage: matter diag info|endpoints|boot",
+        .handler = console_diag_handler,
+    },
+    {
+        .name = "i2c",
+        .description = "I2C bus state, device circuit breakers and bus scan. Usage: matter i2c [info|recover|reset|scan]",
+        .handler = console_i2c_handler,
+    },
+    {
+        .name = "sensor",
+        .description = "Sensor tuning (applied live, saved to nvs) and statistics. gain: 1/8|1/4|1|2, it_ms: 25|50|100|200|400|800. "
+            "Usage: matter sensor show|period <ms> (fixed, ignored while adaptive on)|adaptive off|on [<min_ms> <max_ms> [<change_percent>]]|ranging auto|ranging fixed <gain> <it_ms>|psm off|1~4|deadband <percent>|filter <alpha>|default|commit|stats [reset]|burst <gain> <it_ms> <count>",
+        .handler = console_sensor_handler,
+    },
+};
+#endif
+
+bool register_console_commands()
+{
+#if CONFIG_ENABLE_CHIP_SHELL
+    esp_err_t ret;
+    ret = esp_matter::console::add_commands(console_commands, sizeof(console_commands) / sizeof(console_commands[0]));
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to add console commands (ret: %d)", ret);
+        return false;
+    }
+    ret = esp_matter::console::init();
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to initialize console (ret: %d)", ret);
+        return false;
+    }
+    // input typed while the chip is in light sleep is lost: uart wake-up, no light sleep unless disabled
+#if CONFIG_ESP_CONSOLE_UART
+    GetPowerManager()->enable_uart_wakeup(CONFIG_ESP_CONSOLE_UART_NUM);
+#endif
+#if CONFIG_APP_CONSOLE_NO_LIGHT_SLEEP
+    GetPowerManager()->acquire(ConsoleActive);  // held for the lifetime of the console
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,92 @@
+#include "discovery.h"
+#include "logger.h"
+#include "veml7700.h"
+
+static const i2c_part_t part_table[PartCount] = {
+    // device id code 0x81 (high byte: slave address option code)
+    {"VEML7700", VEML7700_I2CADDR_DEFAULT, 0x07, 0x00FF, 0x0081},
+};
+
+CBusDiscovery* CBusDiscovery::_instance = nullptr;
+
+CBusDiscovery::CBusDiscovery()
+{
+    m_i2c_master = nullptr;
+}
+
+CBusDiscovery::~CBusDiscovery()
+{
+}
+
+CBusDiscovery* CBusDiscovery::Instance()
+{
+    if (!_instance) {
+        _instance = new CBusDiscovery();
+    }
+
+    return _instance;
+}
+
+bool CBusDiscovery::initialize(CI2CMaster *i2c_master)
+{
+    m_i2c_master = i2c_master;
+    return m_i2c_master != nullptr;
+}
+
+int CBusDiscovery::scan(uint8_t *found, int max_count)
+{
+    if (!m_i2c_master)
+        return 0;
+
+    int count = 0;
+    for (uint8_t addr = DISCOVERY_ADDR_FIRST; addr <= DISCOVERY_ADDR_LAST; addr++) {
+        if (m_i2c_master->probe(addr)) {
+            if (found && count < max_count) {
+                found[count] = addr;
+            }
+            count++;
+        }
+    }
+
+    return count;
+}
+
+bool CBusDiscovery::identify(eI2CPart part)
+{
+    if (!m_i2c_master || part >= PartCount)
+        return false;
+
+    const i2c_part_t *info = &part_table[part];
+    uint8_t data_write[1] = {info->id_reg};
+    uint8_t data_read[2] = {0, };
+    if (!m_i2c_master->probe_read(info->dev_addr, data_write, sizeof(data_write), data_read, sizeof(data_read)))
+        return false;
+
+    uint16_t id = ((uint16_t)data_read[1] << 8) | (uint16_t)data_read[0];
+    return (id & info->id_mask) == info->id_value;
+}
+
+const i2c_part_t* CBusDiscovery::get_part(eI2CPart part)
+{
+    if (part >= PartCount)
+        return nullptr;
+    return &part_table[part];
+}
+
+void CBusDiscovery::print_scan()
+{
+    uint8_t found[DISCOVERY_ADDR_LAST - DISCOVERY_ADDR_FIRST + 1];
+    int count = scan(found, sizeof(found));
+
+    GetLogger(eLogType::Info)->Log("I2C Scan (%d devices)", count);
+    for (int i = 0; i < count; i++) {
+        const char *name = "unknown";
+        for (int p = 0; p < PartCount; p++) {
+            if (part_table[p].dev_addr == found[i] && identify((eI2CPart)p)) {
+                name = part_table[p].name;
+                break;
+            }
+        }
+        GetLoggerM(eLogType::Info)->Log("0x%02X: %s", found[i], name);
+    }
+}
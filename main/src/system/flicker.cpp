@@ -0,0 +1,106 @@
+#include "flicker.h"
+#include <math.h>
+#include <string.h>
+
+#define GOERTZEL_COEF_SHIFT     14
+#define MAINS_DETECT_THRESHOLD  2.f     // unit: percent modulation
+#define MIN_SINC_RESPONSE       0.05f
+
+static const float mains_bin_freq[FLICKER_BIN_COUNT] = {100.f, 120.f, 50.f, 60.f};
+
+static float sinc_response(float freq, float integ_time_sec)
+{
+    float x = (float)M_PI * freq * integ_time_sec;
+    if (x == 0.f)
+        return 1.f;
+    return fabsf(sinf(x) / x);
+}
+
+CFlickerAnalyzer::CFlickerAnalyzer()
+{
+}
+
+float CFlickerAnalyzer::goertzel_amplitude(const int32_t *samples, size_t count, float normalized_freq)
+{
+    int32_t coef = (int32_t)lroundf(2.f * cosf(2.f * (float)M_PI * normalized_freq) * (float)(1 << GOERTZEL_COEF_SHIFT));
+    int64_t s0, s1 = 0, s2 = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        s0 = (int64_t)samples[i] + ((coef * s1) >> GOERTZEL_COEF_SHIFT) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    float f1 = (float)s1;
+    float f2 = (float)s2;
+    float power = f1 * f1 + f2 * f2 - ((float)coef / (float)(1 << GOERTZEL_COEF_SHIFT)) * f1 * f2;
+    if (power < 0.f)
+        power = 0.f;
+
+    return 2.f * sqrtf(power) / (float)count;
+}
+
+bool CFlickerAnalyzer::analyze(const uint16_t *samples, size_t count, float sample_rate_hz, float integ_time_sec, flicker_result_t *result)
+{
+    if (!samples || !result || count < 8 || sample_rate_hz <= 0.f)
+        return false;
+    if (count > FLICKER_MAX_SAMPLES)
+        count = FLICKER_MAX_SAMPLES;
+
+    memset(result, 0, sizeof(flicker_result_t));
+    result->sample_count = (uint16_t)count;
+
+    uint32_t sum = 0;
+    uint16_t min_value = samples[0];
+    uint16_t max_value = samples[0];
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+        if (samples[i] < min_value)
+            min_value = samples[i];
+        if (samples[i] > max_value)
+            max_value = samples[i];
+    }
+    if (sum == 0)
+        return true;
+
+    int32_t mean = (int32_t)(sum / count);
+    int32_t centered[FLICKER_MAX_SAMPLES];
+    uint32_t area_above = 0;
+    for (size_t i = 0; i < count; i++) {
+        centered[i] = (int32_t)samples[i] - mean;
+        if (centered[i] > 0)
+            area_above += centered[i];
+    }
+    result->mean = (float)sum / (float)count;
+    result->percent_modulation = 100.f * (float)(max_value - min_value) / (float)(max_value + min_value);
+    result->flicker_index = (float)area_above / (float)sum;
+
+    // hann window (coherent gain 0.5) to reduce leakage of non-integer alias bins
+    for (size_t i = 0; i < count; i++) {
+        int32_t w = (int32_t)lroundf((0.5f - 0.5f * cosf(2.f * (float)M_PI * (float)i / (float)(count - 1))) * (float)(1 << GOERTZEL_COEF_SHIFT));
+        centered[i] = (int32_t)(((int64_t)centered[i] * w) >> GOERTZEL_COEF_SHIFT);
+    }
+
+    // mains flicker at alias bins
+    float resolution_hz = sample_rate_hz / (float)count;
+    for (int i = 0; i < FLICKER_BIN_COUNT; i++) {
+        float freq = mains_bin_freq[i];
+        float alias = fabsf(freq - sample_rate_hz * roundf(freq / sample_rate_hz));
+        float response = sinc_response(freq, integ_time_sec);
+        if (alias < 2.f * resolution_hz || alias > 0.5f * sample_rate_hz - 2.f * resolution_hz || response < MIN_SINC_RESPONSE) {
+            result->bin_modulation[i] = FLICKER_BIN_UNSUPPORTED;
+            result->unsupported_bins |= (uint8_t)(1 << i);
+            continue;
+        }
+        float amplitude = 2.f * goertzel_amplitude(centered, count, alias / sample_rate_hz) / response;
+        float modulation = 100.f * amplitude / result->mean;
+        result->bin_modulation[i] = modulation;
+        if (modulation > MAINS_DETECT_THRESHOLD && modulation > result->mains_modulation) {
+            result->mains_modulation = modulation;
+            // fundamental 50/60 Hz components indicate half-wave flicker of 100/120 Hz mains lighting
+            result->mains_frequency = (freq == 50.f || freq == 100.f) ? 100 : 120;
+        }
+    }
+
+    return true;
+}
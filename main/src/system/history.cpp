@@ -0,0 +1,291 @@
+#include "history.h"
+#include "logger.h"
+#include "definition.h"
+#include "esp_timer.h"
+#include <nvs_flash.h>
+#include <string.h>
+#include <time.h>
+
+#define HISTORY_SECTOR_SIZE     4096
+#define HISTORY_PAGES_PER_SECTOR    (HISTORY_SECTOR_SIZE / HISTORY_PAGE_SIZE)
+
+CHistoryStore* CHistoryStore::_instance = nullptr;
+
+CHistoryStore::CHistoryStore()
+{
+    m_initialized = false;
+    m_partition = nullptr;
+    m_mutex = xSemaphoreCreateMutex();
+    m_page_count = 0;
+    m_write_page = 0;
+    m_sequence = 0;
+    m_written_page_count = 0;
+    m_boot_count = 0;
+}
+
+CHistoryStore::~CHistoryStore()
+{
+}
+
+CHistoryStore* CHistoryStore::Instance()
+{
+    if (!_instance) {
+        _instance = new CHistoryStore();
+    }
+
+    return _instance;
+}
+
+bool CHistoryStore::initialize()
+{
+    esp_err_t ret;
+
+    m_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)HISTORY_PARTITION_SUBTYPE, HISTORY_PARTITION_LABEL);
+    if (!m_partition) {
+        GetLogger(eLogType::Error)->Log("Cannot find history partition");
+        return false;
+    }
+    m_page_count = (m_partition->size / HISTORY_SECTOR_SIZE) * HISTORY_PAGES_PER_SECTOR;
+    if (m_page_count < 2 * HISTORY_PAGES_PER_SECTOR) {
+        GetLogger(eLogType::Error)->Log("History partition is too small (%u bytes)", m_partition->size);
+        return false;
+    }
+
+    // find newest page
+    history_page_header_t header;
+    bool found = false;
+    uint32_t newest_page = 0;
+    uint32_t newest_sequence = 0;
+    m_written_page_count = 0;
+    for (uint32_t i = 0; i < m_page_count; i++) {
+        ret = esp_partition_read(m_partition, i * HISTORY_PAGE_SIZE, &header, sizeof(header));
+        if (ret != ESP_OK || header.magic != HISTORY_PAGE_MAGIC)
+            continue;
+        m_written_page_count++;
+        if (!found || (int32_t)(header.sequence - newest_sequence) > 0) {
+            newest_sequence = header.sequence;
+            newest_page = i;
+            found = true;
+        }
+    }
+
+    // continue writing from the next sector boundary (partially used sector is left as it is)
+    uint32_t next_sector = 0;
+    if (found) {
+        next_sector = (newest_page / HISTORY_PAGES_PER_SECTOR + 1) % (m_page_count / HISTORY_PAGES_PER_SECTOR);
+        m_sequence = newest_sequence + 1;
+    } else {
+        m_sequence = 0;
+    }
+    m_write_page = next_sector * HISTORY_PAGES_PER_SECTOR;
+    for (uint32_t i = m_write_page; i < m_write_page + HISTORY_PAGES_PER_SECTOR; i++) {
+        ret = esp_partition_read(m_partition, i * HISTORY_PAGE_SIZE, &header, sizeof(header));
+        if (ret == ESP_OK && header.magic == HISTORY_PAGE_MAGIC)
+            m_written_page_count--;
+    }
+    ret = esp_partition_erase_range(m_partition, next_sector * HISTORY_SECTOR_SIZE, HISTORY_SECTOR_SIZE);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to erase history sector (ret: %d)", ret);
+        return false;
+    }
+    if (!load_boot_count()) {
+        GetLogger(eLogType::Warning)->Log("Failed to update boot count, uptime timestamps may overlap previous boot");
+    }
+    m_encoder.begin(m_sequence, m_boot_count);
+
+    m_initialized = true;
+    GetLogger(eLogType::Info)->Log("Initialized (pages: %u, used: %u, write page: %u, sequence: %u, boot: %u)",
+        m_page_count, m_written_page_count, m_write_page, m_sequence, m_boot_count);
+    return true;
+}
+
+bool CHistoryStore::load_boot_count()
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(HISTORY_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK)
+        return false;
+    uint16_t boot_count = 0;
+    nvs_get_u16(handle, HISTORY_NVS_KEY_BOOT, &boot_count);     // not found: first boot
+    m_boot_count = boot_count + 1;
+    ret = nvs_set_u16(handle, HISTORY_NVS_KEY_BOOT, m_boot_count);
+    if (ret == ESP_OK)
+        ret = nvs_commit(handle);
+    nvs_close(handle);
+    return ret == ESP_OK;
+}
+
+bool CHistoryStore::append(float value)
+{
+    if (!m_initialized)
+        return false;
+
+    bool result = true;
+    history_sample_t sample;
+    time_t now = time(nullptr);
+    uint8_t flags = 0;
+    if (now >= HISTORY_EPOCH_MIN) {
+        sample.timestamp = (uint32_t)now;
+        flags = HISTORY_FLAG_EPOCH;
+    } else {
+        sample.timestamp = (uint32_t)(esp_timer_get_time() / 1000000LL);
+    }
+    sample.value = value;
+    sample.boot_count = m_boot_count;
+    sample.flags = flags;
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    if (m_encoder.get_flags() != flags) {
+        // clock got synced (or lost): a page holds timestamps of one clock source only
+        if (m_encoder.get_count() > 0)
+            result = write_current_page();
+        m_encoder.begin(m_sequence, m_boot_count, flags);
+    }
+    if (!m_encoder.append(&sample)) {
+        result = write_current_page();
+        m_encoder.append(&sample);
+    }
+    xSemaphoreGive(m_mutex);
+
+    return result;
+}
+
+bool CHistoryStore::flush()
+{
+    if (!m_initialized)
+        return false;
+
+    bool result = true;
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    if (m_encoder.get_count() > 0) {
+        result = write_current_page();
+    }
+    xSemaphoreGive(m_mutex);
+
+    return result;
+}
+
+bool CHistoryStore::write_current_page()
+{
+    esp_err_t ret;
+
+    m_encoder.finish();
+    ret = esp_partition_write(m_partition, m_write_page * HISTORY_PAGE_SIZE, m_encoder.get_data(), HISTORY_PAGE_SIZE);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to write history page %u (ret: %d)", m_write_page, ret);
+    }
+
+    m_write_page = (m_write_page + 1) % m_page_count;
+    m_sequence++;
+    m_encoder.begin(m_sequence, m_boot_count, m_encoder.get_flags());
+    if (m_written_page_count < m_page_count)
+        m_written_page_count++;
+
+    if (m_write_page % HISTORY_PAGES_PER_SECTOR == 0) {
+        // drop the oldest sector
+        esp_err_t ret_erase = esp_partition_erase_range(m_partition, m_write_page * HISTORY_PAGE_SIZE, HISTORY_SECTOR_SIZE);
+        if (ret_erase != ESP_OK) {
+            GetLogger(eLogType::Error)->Log("Failed to erase history sector (ret: %d)", ret_erase);
+        }
+        if (m_written_page_count > m_page_count - HISTORY_PAGES_PER_SECTOR)
+            m_written_page_count = m_page_count - HISTORY_PAGES_PER_SECTOR;
+    }
+
+    return ret == ESP_OK;
+}
+
+bool CHistoryStore::read_page(uint32_t page_index, uint8_t *buffer)
+{
+    esp_err_t ret = esp_partition_read(m_partition, page_index * HISTORY_PAGE_SIZE, buffer, HISTORY_PAGE_SIZE);
+    return ret == ESP_OK;
+}
+
+void CHistoryStore::print_info()
+{
+    GetLogger(eLogType::Info)->Log("History Store Info");
+    if (!m_initialized) {
+        GetLoggerM(eLogType::Info)->Log("Not initialized");
+        return;
+    }
+    GetLoggerM(eLogType::Info)->Log("Partition: %s (offset: 0x%X, size: %u)", m_partition->label, m_partition->address, m_partition->size);
+    GetLoggerM(eLogType::Info)->Log("Pages: %u/%u used, write page: %u, sequence: %u", m_written_page_count, m_page_count, m_write_page, m_sequence);
+    GetLoggerM(eLogType::Info)->Log("Pending samples: %u (%u bytes)", m_encoder.get_count(), m_encoder.get_used_size());
+    GetLoggerM(eLogType::Info)->Log("Boot: %u, clock: %s", m_boot_count, m_encoder.get_flags() & HISTORY_FLAG_EPOCH ? "unix time" : "uptime (not synced)");
+}
+
+CHistoryReader::CHistoryReader()
+{
+    m_store = GetHistoryStore();
+    m_since_timestamp = 0;
+    m_start_page = 0;
+    m_pages_visited = 0;
+    m_pending_page_visited = false;
+    m_decoder_valid = false;
+}
+
+bool CHistoryReader::begin(uint32_t since_timestamp)
+{
+    if (!m_store->m_initialized)
+        return false;
+
+    m_since_timestamp = since_timestamp;
+    xSemaphoreTake(m_store->m_mutex, portMAX_DELAY);
+    // oldest data is right after the write position (ring order)
+    m_start_page = m_store->m_write_page;
+    xSemaphoreGive(m_store->m_mutex);
+    m_pages_visited = 0;
+    m_pending_page_visited = false;
+    m_decoder_valid = false;
+    return true;
+}
+
+bool CHistoryReader::load_next_page()
+{
+    m_decoder_valid = false;
+    while (m_pages_visited < m_store->m_page_count) {
+        uint32_t page_index = (m_start_page + m_pages_visited) % m_store->m_page_count;
+        m_pages_visited++;
+        xSemaphoreTake(m_store->m_mutex, portMAX_DELAY);
+        bool valid = m_store->read_page(page_index, m_buffer);
+        xSemaphoreGive(m_store->m_mutex);
+        if (valid && m_decoder.begin(m_buffer, sizeof(m_buffer))) {
+            m_decoder_valid = true;
+            return true;
+        }
+    }
+
+    if (!m_pending_page_visited) {
+        // samples not written to flash yet
+        m_pending_page_visited = true;
+        xSemaphoreTake(m_store->m_mutex, portMAX_DELAY);
+        bool has_pending = m_store->m_encoder.get_count() > 0;
+        if (has_pending) {
+            CHistoryPageEncoder temp = m_store->m_encoder;
+            temp.finish();
+            memcpy(m_buffer, temp.get_data(), HISTORY_PAGE_SIZE);
+        }
+        xSemaphoreGive(m_store->m_mutex);
+        if (has_pending && m_decoder.begin(m_buffer, sizeof(m_buffer))) {
+            m_decoder_valid = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CHistoryReader::next(history_sample_t *sample)
+{
+    history_sample_t temp;
+    while (true) {
+        if (!m_decoder_valid || !m_decoder.next(&temp)) {
+            if (!load_next_page())
+                return false;
+            continue;
+        }
+        if (m_since_timestamp == 0 || ((temp.flags & HISTORY_FLAG_EPOCH) && temp.timestamp >= m_since_timestamp)) {
+            if (sample)
+                *sample = temp;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,207 @@
+#include "historycodec.h"
+#include <string.h>
+
+static inline uint64_t zigzag_encode(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline uint32_t float_to_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bits_to_float(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+size_t history_varint_encode(uint64_t value, uint8_t *out)
+{
+    size_t len = 0;
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+size_t history_varint_decode(const uint8_t *data, size_t size, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < size && i < 10; i++) {
+        result |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t history_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t page_crc(const uint8_t *page, size_t size)
+{
+    size_t crc_offset = offsetof(history_page_header_t, crc);
+    uint32_t crc = history_crc32(0, page, crc_offset);
+    return history_crc32(crc, page + sizeof(history_page_header_t), size - sizeof(history_page_header_t));
+}
+
+CHistoryPageEncoder::CHistoryPageEncoder()
+{
+    begin(0);
+}
+
+void CHistoryPageEncoder::begin(uint32_t sequence, uint16_t boot_count/*=0*/, uint8_t flags/*=0*/)
+{
+    memset(m_page, 0xFF, sizeof(m_page));
+    m_offset = sizeof(history_page_header_t);
+    m_count = 0;
+    m_sequence = sequence;
+    m_boot_count = boot_count;
+    m_flags = flags;
+    m_prev_timestamp = 0;
+    m_prev_delta = 0;
+    m_prev_value_bits = 0;
+}
+
+bool CHistoryPageEncoder::append(const history_sample_t *sample)
+{
+    history_page_header_t *header = (history_page_header_t *)m_page;
+    uint32_t value_bits = float_to_bits(sample->value);
+
+    if (m_count == 0) {
+        header->base_timestamp = sample->timestamp;
+        header->base_value = value_bits;
+    } else {
+        uint8_t record[16];
+        size_t len = 0;
+        int64_t delta = (int64_t)sample->timestamp - (int64_t)m_prev_timestamp;
+        len += history_varint_encode(zigzag_encode(delta - m_prev_delta), &record[len]);
+        uint32_t xor_bits = value_bits ^ m_prev_value_bits;
+        if (xor_bits == 0) {
+            len += history_varint_encode(0, &record[len]);
+        } else {
+            uint32_t tz = __builtin_ctz(xor_bits);
+            len += history_varint_encode(((uint64_t)(xor_bits >> tz) << 5) | tz, &record[len]);
+        }
+        if (m_offset + len > HISTORY_PAGE_SIZE)
+            return false;
+        memcpy(&m_page[m_offset], record, len);
+        m_offset += len;
+        m_prev_delta = delta;
+    }
+
+    m_prev_timestamp = sample->timestamp;
+    m_prev_value_bits = value_bits;
+    m_count++;
+    return true;
+}
+
+void CHistoryPageEncoder::finish()
+{
+    history_page_header_t *header = (history_page_header_t *)m_page;
+    header->magic = HISTORY_PAGE_MAGIC;
+    header->count = m_count;
+    header->sequence = m_sequence;
+    header->boot_count = m_boot_count;
+    header->flags = m_flags;
+    header->reserved = 0;
+    header->crc = page_crc(m_page, HISTORY_PAGE_SIZE);
+}
+
+CHistoryPageDecoder::CHistoryPageDecoder()
+{
+    m_page = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_count = 0;
+    m_index = 0;
+    m_sequence = 0;
+    m_boot_count = 0;
+    m_flags = 0;
+    m_prev_timestamp = 0;
+    m_prev_delta = 0;
+    m_prev_value_bits = 0;
+}
+
+bool CHistoryPageDecoder::begin(const uint8_t *page, size_t size)
+{
+    m_page = nullptr;
+    if (!page || size < HISTORY_PAGE_SIZE)
+        return false;
+
+    const history_page_header_t *header = (const history_page_header_t *)page;
+    if (header->magic != HISTORY_PAGE_MAGIC || header->count == 0)
+        return false;
+    if (header->crc != page_crc(page, HISTORY_PAGE_SIZE))
+        return false;
+
+    m_page = page;
+    m_size = HISTORY_PAGE_SIZE;
+    m_offset = sizeof(history_page_header_t);
+    m_count = header->count;
+    m_index = 0;
+    m_sequence = header->sequence;
+    m_boot_count = header->boot_count;
+    m_flags = header->flags;
+    m_prev_timestamp = header->base_timestamp;
+    m_prev_delta = 0;
+    m_prev_value_bits = header->base_value;
+    return true;
+}
+
+bool CHistoryPageDecoder::next(history_sample_t *sample)
+{
+    if (!m_page || m_index >= m_count)
+        return false;
+
+    if (m_index > 0) {
+        uint64_t dod, token;
+        size_t len = history_varint_decode(&m_page[m_offset], m_size - m_offset, &dod);
+        if (len == 0)
+            return false;
+        m_offset += len;
+        len = history_varint_decode(&m_page[m_offset], m_size - m_offset, &token);
+        if (len == 0)
+            return false;
+        m_offset += len;
+
+        m_prev_delta += zigzag_decode(dod);
+        m_prev_timestamp = (uint32_t)((int64_t)m_prev_timestamp + m_prev_delta);
+        if (token != 0) {
+            uint32_t tz = (uint32_t)(token & 0x1F);
+            m_prev_value_bits ^= (uint32_t)((token >> 5) << tz);
+        }
+    }
+
+    if (sample) {
+        sample->timestamp = m_prev_timestamp;
+        sample->value = bits_to_float(m_prev_value_bits);
+        sample->boot_count = m_boot_count;
+        sample->flags = m_flags;
+    }
+    m_index++;
+    return true;
+}
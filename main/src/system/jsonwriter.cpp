@@ -0,0 +1,200 @@
+#include "jsonwriter.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+
+void json_sink_stdout(const char *data, size_t len, void *ctx)
+{
+    fwrite(data, 1, len, stdout);
+}
+
+void json_sink_buffer(const char *data, size_t len, void *ctx)
+{
+    json_buffer_t *buffer = static_cast<json_buffer_t *>(ctx);
+    if (!buffer)
+        return;
+    if (buffer->data && buffer->len < buffer->size) {
+        size_t copy_len = buffer->size - buffer->len;
+        if (copy_len > len)
+            copy_len = len;
+        memcpy(buffer->data + buffer->len, data, copy_len);
+    }
+    buffer->len += len;
+}
+
+CJsonWriter::CJsonWriter(json_sink_t sink, void *ctx)
+{
+    m_sink = sink;
+    m_ctx = ctx;
+    m_length = 0;
+    m_depth = 0;
+    m_first[0] = true;
+    m_valid = true;
+}
+
+CJsonWriter::~CJsonWriter()
+{
+    flush();
+}
+
+void CJsonWriter::put(char c)
+{
+    if (m_length >= JSON_WRITER_CHUNK_SIZE)
+        flush();
+    m_buffer[m_length++] = c;
+}
+
+void CJsonWriter::put(const char *str)
+{
+    while (*str) {
+        put(*str++);
+    }
+}
+
+void CJsonWriter::put_escaped(const char *str, int max_len)
+{
+    char temp[8];
+    put('"');
+    for (int i = 0; str && (max_len < 0 || i < max_len) && str[i]; i++) {
+        unsigned char c = (unsigned char)str[i];
+        switch (c) {
+        case '"': put("\\\""); break;
+        case '\\': put("\\\\"); break;
+        case '\b': put("\\b"); break;
+        case '\f': put("\\f"); break;
+        case '\n': put("\\n"); break;
+        case '\r': put("\\r"); break;
+        case '\t': put("\\t"); break;
+        default:
+            if (c < 0x20) {
+                snprintf(temp, sizeof(temp), "\\u%04x", c);
+                put(temp);
+            } else {
+                put((char)c);
+            }
+            break;
+        }
+    }
+    put('"');
+}
+
+void CJsonWriter::begin_value(const char *key)
+{
+    if (!m_first[m_depth])
+        put(',');
+    m_first[m_depth] = false;
+    if (key && m_depth > 0) {
+        put_escaped(key, -1);
+        put(':');
+    }
+}
+
+bool CJsonWriter::begin_object(const char *key/*=nullptr*/)
+{
+    if (m_depth >= JSON_WRITER_MAX_DEPTH) {
+        m_valid = false;
+        return false;
+    }
+    begin_value(key);
+    put('{');
+    m_first[++m_depth] = true;
+    return true;
+}
+
+bool CJsonWriter::end_object()
+{
+    if (m_depth <= 0) {
+        m_valid = false;
+        return false;
+    }
+    m_depth--;
+    put('}');
+    return true;
+}
+
+bool CJsonWriter::begin_array(const char *key/*=nullptr*/)
+{
+    if (m_depth >= JSON_WRITER_MAX_DEPTH) {
+        m_valid = false;
+        return false;
+    }
+    begin_value(key);
+    put('[');
+    m_first[++m_depth] = true;
+    return true;
+}
+
+bool CJsonWriter::end_array()
+{
+    if (m_depth <= 0) {
+        m_valid = false;
+        return false;
+    }
+    m_depth--;
+    put(']');
+    return true;
+}
+
+void CJsonWriter::write_string(const char *key, const char *value, int max_len/*=-1*/)
+{
+    begin_value(key);
+    put_escaped(value, max_len);
+}
+
+void CJsonWriter::write_int(const char *key, int64_t value)
+{
+    char temp[24];
+    begin_value(key);
+    snprintf(temp, sizeof(temp), "%" PRId64, value);
+    put(temp);
+}
+
+void CJsonWriter::write_uint(const char *key, uint64_t value)
+{
+    char temp[24];
+    begin_value(key);
+    snprintf(temp, sizeof(temp), "%" PRIu64, value);
+    put(temp);
+}
+
+void CJsonWriter::write_float(const char *key, double value)
+{
+    char temp[32];
+    begin_value(key);
+    // json has no representation of nan / inf
+    if (isnan(value) || isinf(value)) {
+        put("null");
+        return;
+    }
+    snprintf(temp, sizeof(temp), "%.9g", value);
+    put(temp);
+}
+
+void CJsonWriter::write_bool(const char *key, bool value)
+{
+    begin_value(key);
+    put(value ? "true" : "false");
+}
+
+void CJsonWriter::write_null(const char *key)
+{
+    begin_value(key);
+    put("null");
+}
+
+void CJsonWriter::write_hex(const char *key, uint32_t value, int width)
+{
+    char temp[16];
+    begin_value(key);
+    snprintf(temp, sizeof(temp), "\"0x%0*" PRIX32 "\"", width, value);
+    put(temp);
+}
+
+void CJsonWriter::flush()
+{
+    if (m_length > 0 && m_sink) {
+        m_sink(m_buffer, m_length, m_ctx);
+    }
+    m_length = 0;
+}
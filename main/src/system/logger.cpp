@@ -2,6 +2,7 @@
 #ifndef UNIT_TEST
 #include "freertos/FreeRTOS.h"
 #include "esp_log.h"
+#include "trace.h"
 #endif
 #include <vector>
 #include <cstdarg>
@@ -77,6 +78,9 @@ void CLogger::Log(const char* msg, ...)
 
 void CLogger::Process(std::string msg)
 {
+#ifndef UNIT_TEST
+    TRACE_SCOPE("log");
+#endif
     std::string fullmsg;
     std::string funcname;
     size_t colons, begin, end;
@@ -0,0 +1,459 @@
+#include "matternames.h"
+#include "sdkconfig.h"
+#include <stddef.h>
+
+typedef struct matter_name_entry {
+    uint32_t id;
+    const char *name;
+} matter_name_entry_t;
+
+#if CONFIG_APP_MATTER_NAME_TABLE
+/*
+ * name tables are sorted by id (checked at compile time) and placed in flash (rodata),
+ * attribute / command key = (cluster id << 16) | attribute or command id
+ * contents are checked against the previous switch implementation by scripts/matter_names_test.cpp
+ */
+#define MATTER_NAME_KEY(cluster_id, id)     (((uint32_t)(cluster_id) << 16) | (uint32_t)(id))
+
+static constexpr matter_name_entry_t device_type_names[] = {
+    {0x000A, "Door Lock"},
+    {0x000B, "Door Lock Controller"},
+    {0x000E, "Aggregator"},
+    {0x000F, "Generic Switch"},
+    {0x0011, "Power Source"},
+    {0x0012, "OTA Requestor"},
+    {0x0013, "Bridged Node"},
+    {0x0014, "OTA Provider"},
+    {0x0015, "Contact Sensor"},
+    {0x0016, "Root Node"},
+    {0x0022, "Speaker"},
+    {0x0023, "Casting Video Player"},
+    {0x0024, "Content App"},
+    {0x0027, "Mode Select"},
+    {0x0028, "Basic Video Player"},
+    {0x0029, "Casting Video Client"},
+    {0x002A, "Video Remote Control"},
+    {0x002B, "Fan"},
+    {0x0100, "On/Off Light"},
+    {0x0101, "Dimmable Light"},
+    {0x0103, "On/Off Light Switch"},
+    {0x0104, "Dimmer Switch"},
+    {0x0105, "Color Dimmer Switch"},
+    {0x0106, "Light Sensor"},
+    {0x0107, "Occupancy Sensor"},
+    {0x010A, "On/Off Plug-in Unit"},
+    {0x010B, "Dimmable Plug-In Unit"},
+    {0x010C, "Color Temperature Light"},
+    {0x010D, "Extended Color Light"},
+    {0x0202, "Window Covering"},
+    {0x0203, "Window Covering Controller"},
+    {0x0300, "Heating/Cooling Unit"},
+    {0x0301, "Thermostat"},
+    {0x0302, "Temperature Sensor"},
+    {0x0303, "Pump"},
+    {0x0304, "Pump Controller"},
+    {0x0305, "Pressure Sensor"},
+    {0x0306, "Flow Sensor"},
+    {0x0307, "Humidity Sensor"},
+    {0x0840, "Control Bridge"},
+    {0x0850, "On/Off Sensor"},
+};
+
+static constexpr matter_name_entry_t cluster_names[] = {
+    {0x0003, "Identify"},
+    {0x0004, "Groups"},
+    {0x0005, "Scenes"},
+    {0x0006, "On/Off"},
+    {0x0008, "Level Control"},
+    {0x0009, "Alarms"},
+    {0x000A, "Time"},
+    {0x001D, "Descriptor"},
+    {0x001E, "Binding"},
+    {0x001F, "Access Control"},
+    {0x0020, "Poll Control"},
+    {0x0028, "Basic Information"},
+    {0x0029, "OTA Software Update Provider"},
+    {0x002A, "OTA Software Update Requestor"},
+    {0x002B, "Localization Configuration"},
+    {0x002C, "Time Format Localization"},
+    {0x002D, "Unit Localization"},
+    {0x002E, "Power Source Configuration"},
+    {0x002F, "Power Source"},
+    {0x0030, "General Commisioning"},
+    {0x0031, "Network Commisioning"},
+    {0x0032, "diagnostic Logs"},
+    {0x0033, "General Diagnostics"},
+    {0x0034, "Software Diagnostics"},
+    {0x0035, "Thread Network Diagnostics"},
+    {0x0036, "Wi-Fi Network Diagnostics"},
+    {0x0037, "Ethernet Network Diagnostics"},
+    {0x0038, "Time Synchronization"},
+    {0x0039, "Bridged Device Basic Information"},
+    {0x003B, "Switch"},
+    {0x003C, "Administrator Commisioning"},
+    {0x003E, "Node Operational Credentials"},
+    {0x003F, "Group Key Management"},
+    {0x0040, "Fixed Label"},
+    {0x0041, "User Label"},
+    {0x0045, "Boolean State"},
+    {0x0050, "Mode Select"},
+    {0x0101, "Door Lock"},
+    {0x0102, "Window Covering"},
+    {0x0200, "Pump Configuration and Control"},
+    {0x0201, "Thermostat"},
+    {0x0202, "Fan Control"},
+    {0x0204, "Thermostat User Interface Configuration"},
+    {0x0300, "Color Control"},
+    {0x0400, "Illuminance Measurement"},
+    {0x0402, "Temperature Measurement"},
+    {0x0403, "Pressure Measurement"},
+    {0x0404, "Flow Measurement"},
+    {0x0405, "Relative Humidity Measurement"},
+    {0x0406, "Occupancy Sensing"},
+    {0x0503, "Wake On LAN"},
+    {0x0504, "Channel"},
+    {0x0505, "Target Navigator"},
+    {0x0506, "Media Playback"},
+    {0x0507, "Media Input"},
+    {0x0508, "Low Power"},
+    {0x0509, "Keypad Input"},
+    {0x050A, "Content Launcher"},
+    {0x050B, "Audio Output"},
+    {0x050C, "Application Launcher"},
+    {0x050D, "Application Basic"},
+    {0x050E, "Account Login"},
+};
+
+static constexpr matter_name_entry_t global_attribute_names[] = {
+    {0x00FE, "FabricIndex"},
+    {0xFFF8, "GeneratedCommandList"},
+    {0xFFF9, "AcceptedCommandList"},
+    {0xFFFA, "EventList"},
+    {0xFFFB, "AttributeList"},
+    {0xFFFC, "FeatureMap"},
+    {0xFFFD, "ClusterRevision"},
+};
+
+static constexpr matter_name_entry_t attribute_names[] = {
+    /* Identify */
+    {MATTER_NAME_KEY(0x0003, 0x0000), "IdentifyTime"},
+    {MATTER_NAME_KEY(0x0003, 0x0001), "IdentifyType"},
+    /* Groups */
+    {MATTER_NAME_KEY(0x0004, 0x0000), "NameSupport"},
+    /* Scenes */
+    {MATTER_NAME_KEY(0x0005, 0x0000), "SceneCount"},
+    {MATTER_NAME_KEY(0x0005, 0x0001), "CurrentScene"},
+    {MATTER_NAME_KEY(0x0005, 0x0002), "CurrentGroup"},
+    {MATTER_NAME_KEY(0x0005, 0x0003), "SceneValid"},
+    {MATTER_NAME_KEY(0x0005, 0x0004), "NameSupport"},
+    {MATTER_NAME_KEY(0x0005, 0x0005), "LastConfiguredBy"},
+    /* On/Off */
+    {MATTER_NAME_KEY(0x0006, 0x0000), "OnOff"},
+    {MATTER_NAME_KEY(0x0006, 0x4000), "GlobalSceneControl"},
+    {MATTER_NAME_KEY(0x0006, 0x4001), "OnTime"},
+    {MATTER_NAME_KEY(0x0006, 0x4002), "OffWaitTime"},
+    {MATTER_NAME_KEY(0x0006, 0x4003), "StartUpOnOff"},
+    /* Level Control */
+    {MATTER_NAME_KEY(0x0008, 0x0000), "CurrentLevel"},
+    {MATTER_NAME_KEY(0x0008, 0x0001), "RemainingTime"},
+    {MATTER_NAME_KEY(0x0008, 0x0002), "MinLevel"},
+    {MATTER_NAME_KEY(0x0008, 0x0003), "MaxLevel"},
+    {MATTER_NAME_KEY(0x0008, 0x0004), "CurrentFrequency"},
+    {MATTER_NAME_KEY(0x0008, 0x0005), "MinFrequency"},
+    {MATTER_NAME_KEY(0x0008, 0x0006), "MaxFrequency"},
+    {MATTER_NAME_KEY(0x0008, 0x000F), "Options"},
+    {MATTER_NAME_KEY(0x0008, 0x0010), "OnOffTransitionTime"},
+    {MATTER_NAME_KEY(0x0008, 0x0011), "OnLevel"},
+    {MATTER_NAME_KEY(0x0008, 0x0012), "OnTransitionTime"},
+    {MATTER_NAME_KEY(0x0008, 0x0013), "OffTransitionTime"},
+    {MATTER_NAME_KEY(0x0008, 0x0014), "DefaultMoveRate"},
+    {MATTER_NAME_KEY(0x0008, 0x4000), "StartUpCurrentLevel"},
+    /* Descriptor */
+    {MATTER_NAME_KEY(0x001D, 0x0000), "DeviceTypeList"},
+    {MATTER_NAME_KEY(0x001D, 0x0001), "ServerList"},
+    {MATTER_NAME_KEY(0x001D, 0x0002), "ClientList"},
+    {MATTER_NAME_KEY(0x001D, 0x0003), "PartsList"},
+    /* Access Control */
+    {MATTER_NAME_KEY(0x001F, 0x0000), "ACL"},
+    {MATTER_NAME_KEY(0x001F, 0x0001), "Extension"},
+    {MATTER_NAME_KEY(0x001F, 0x0002), "SubjectsPerAccessControlEntry"},
+    {MATTER_NAME_KEY(0x001F, 0x0003), "TargetsPerAccessControlEntry"},
+    {MATTER_NAME_KEY(0x001F, 0x0004), "AccessControlEntriesPerFabric"},
+    /* Basic Information (Bridged Device Basic Information) */
+    {MATTER_NAME_KEY(0x0028, 0x0000), "DataModelRevision"},
+    {MATTER_NAME_KEY(0x0028, 0x0001), "VendorName"},
+    {MATTER_NAME_KEY(0x0028, 0x0002), "VendorID"},
+    {MATTER_NAME_KEY(0x0028, 0x0003), "ProductName"},
+    {MATTER_NAME_KEY(0x0028, 0x0004), "ProductID"},
+    {MATTER_NAME_KEY(0x0028, 0x0005), "NodeLabel"},
+    {MATTER_NAME_KEY(0x0028, 0x0006), "Location"},
+    {MATTER_NAME_KEY(0x0028, 0x0007), "HardwareVersion"},
+    {MATTER_NAME_KEY(0x0028, 0x0008), "HardwareVersionString"},
+    {MATTER_NAME_KEY(0x0028, 0x0009), "SoftwareVersion"},
+    {MATTER_NAME_KEY(0x0028, 0x000A), "SoftwareVersionString"},
+    {MATTER_NAME_KEY(0x0028, 0x000B), "ManufacturingDate"},
+    {MATTER_NAME_KEY(0x0028, 0x000C), "PartNumber"},
+    {MATTER_NAME_KEY(0x0028, 0x000D), "ProductURL"},
+    {MATTER_NAME_KEY(0x0028, 0x000E), "ProductLabel"},
+    {MATTER_NAME_KEY(0x0028, 0x000F), "SerialNumber"},
+    {MATTER_NAME_KEY(0x0028, 0x0010), "LocalConfigDisabled"},
+    {MATTER_NAME_KEY(0x0028, 0x0011), "Reachable"},
+    {MATTER_NAME_KEY(0x0028, 0x0012), "UniqueID"},
+    {MATTER_NAME_KEY(0x0028, 0x0013), "CapabilityMinima"},
+    /* General Commisioning */
+    {MATTER_NAME_KEY(0x0030, 0x0000), "Breadcrumb"},
+    {MATTER_NAME_KEY(0x0030, 0x0001), "BasicCommisioningInfo"},
+    {MATTER_NAME_KEY(0x0030, 0x0002), "RegulatoryConfig"},
+    {MATTER_NAME_KEY(0x0030, 0x0003), "LocationCapability"},
+    {MATTER_NAME_KEY(0x0030, 0x0004), "SupportsConcurrentConnection"},
+    /* Color Control */
+    {MATTER_NAME_KEY(0x0300, 0x0000), "CurrentHue"},
+    {MATTER_NAME_KEY(0x0300, 0x0001), "CurrentSaturation"},
+    {MATTER_NAME_KEY(0x0300, 0x0002), "RemainingTime"},
+    {MATTER_NAME_KEY(0x0300, 0x0003), "CurrentX"},
+    {MATTER_NAME_KEY(0x0300, 0x0004), "CurrentY"},
+    {MATTER_NAME_KEY(0x0300, 0x0005), "DriftCompensation"},
+    {MATTER_NAME_KEY(0x0300, 0x0006), "CompensationText"},
+    {MATTER_NAME_KEY(0x0300, 0x0007), "ColorTemperatureMireds"},
+    {MATTER_NAME_KEY(0x0300, 0x0008), "ColorMode"},
+    {MATTER_NAME_KEY(0x0300, 0x000F), "Options"},
+    {MATTER_NAME_KEY(0x0300, 0x0010), "NumberOfPrimaries"},
+    {MATTER_NAME_KEY(0x0300, 0x0011), "Primary1X"},
+    {MATTER_NAME_KEY(0x0300, 0x0012), "Primary1Y"},
+    {MATTER_NAME_KEY(0x0300, 0x0013), "Primary1Intensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0015), "Primary2X"},
+    {MATTER_NAME_KEY(0x0300, 0x0016), "Primary2Y"},
+    {MATTER_NAME_KEY(0x0300, 0x0017), "Primary2Intensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0019), "Primary3X"},
+    {MATTER_NAME_KEY(0x0300, 0x001A), "Primary3Y"},
+    {MATTER_NAME_KEY(0x0300, 0x001B), "Primary3Intensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0020), "Primary4X"},
+    {MATTER_NAME_KEY(0x0300, 0x0021), "Primary4Y"},
+    {MATTER_NAME_KEY(0x0300, 0x0022), "Primary4Intensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0024), "Primary5X"},
+    {MATTER_NAME_KEY(0x0300, 0x0025), "Primary5Y"},
+    {MATTER_NAME_KEY(0x0300, 0x0026), "Primary5Intensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0028), "Primary6X"},
+    {MATTER_NAME_KEY(0x0300, 0x0029), "Primary6Y"},
+    {MATTER_NAME_KEY(0x0300, 0x002A), "Primary6Intensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0030), "WhitePointX"},
+    {MATTER_NAME_KEY(0x0300, 0x0031), "WhitePointY"},
+    {MATTER_NAME_KEY(0x0300, 0x0032), "ColorPointRX"},
+    {MATTER_NAME_KEY(0x0300, 0x0033), "ColorPointRY"},
+    {MATTER_NAME_KEY(0x0300, 0x0034), "ColorPointRIntensity"},
+    {MATTER_NAME_KEY(0x0300, 0x0036), "ColorPointGX"},
+    {MATTER_NAME_KEY(0x0300, 0x0037), "ColorPointGY"},
+    {MATTER_NAME_KEY(0x0300, 0x0038), "ColorPointGIntensity"},
+    {MATTER_NAME_KEY(0x0300, 0x003A), "ColorPointBX"},
+    {MATTER_NAME_KEY(0x0300, 0x003B), "ColorPointBY"},
+    {MATTER_NAME_KEY(0x0300, 0x003C), "ColorPointBIntensity"},
+    {MATTER_NAME_KEY(0x0300, 0x4000), "EnhancedCurrentHue"},
+    {MATTER_NAME_KEY(0x0300, 0x4001), "EnhancedColorMode"},
+    {MATTER_NAME_KEY(0x0300, 0x4002), "ColorLoopActive"},
+    {MATTER_NAME_KEY(0x0300, 0x4003), "ColorLoopDirection"},
+    {MATTER_NAME_KEY(0x0300, 0x4004), "ColorLoopTime"},
+    {MATTER_NAME_KEY(0x0300, 0x4005), "ColorLoopStartEnhancedHue"},
+    {MATTER_NAME_KEY(0x0300, 0x4006), "ColorLoopStoredEnhancedHue"},
+    {MATTER_NAME_KEY(0x0300, 0x400A), "ColorCapabilities"},
+    {MATTER_NAME_KEY(0x0300, 0x400B), "ColorTempPhysicalMinMireds"},
+    {MATTER_NAME_KEY(0x0300, 0x400C), "ColorTempPhysicalMaxMireds"},
+    {MATTER_NAME_KEY(0x0300, 0x400D), "CoupleColorTempToLevelMinMireds"},
+    {MATTER_NAME_KEY(0x0300, 0x4010), "StartUpColorTemperatureMireds"},
+    /* Ballast Configuration */
+    {MATTER_NAME_KEY(0x0301, 0x0000), "PhysicalMinLevel"},
+    {MATTER_NAME_KEY(0x0301, 0x0001), "PhysicalMaxLevel"},
+    {MATTER_NAME_KEY(0x0301, 0x0002), "BallastStatus"},
+    {MATTER_NAME_KEY(0x0301, 0x0010), "MinLevel"},
+    {MATTER_NAME_KEY(0x0301, 0x0011), "MaxLevel"},
+    {MATTER_NAME_KEY(0x0301, 0x0012), "PowerOnLevel"},
+    {MATTER_NAME_KEY(0x0301, 0x0013), "PowerOnFadeTime"},
+    {MATTER_NAME_KEY(0x0301, 0x0014), "IntrinsicBallastFactor"},
+    {MATTER_NAME_KEY(0x0301, 0x0015), "BallastFactorAdjustment"},
+    {MATTER_NAME_KEY(0x0301, 0x0020), "LampQuantity"},
+    {MATTER_NAME_KEY(0x0301, 0x0030), "LampType"},
+    {MATTER_NAME_KEY(0x0301, 0x0031), "LampManufacturer"},
+    {MATTER_NAME_KEY(0x0301, 0x0032), "LampRatedHours"},
+    {MATTER_NAME_KEY(0x0301, 0x0033), "LampBurnHours"},
+    {MATTER_NAME_KEY(0x0301, 0x0034), "LampAlarmMode"},
+    {MATTER_NAME_KEY(0x0301, 0x0035), "LampBurnHoursTripPoint"},
+    /* Illuminance Measurement */
+    {MATTER_NAME_KEY(0x0400, 0x0000), "MeasuredValue"},
+    {MATTER_NAME_KEY(0x0400, 0x0001), "MinMeasuredValue"},
+    {MATTER_NAME_KEY(0x0400, 0x0002), "MaxMeasuredValue"},
+    {MATTER_NAME_KEY(0x0400, 0x0003), "Tolerance"},
+    {MATTER_NAME_KEY(0x0400, 0x0004), "LightSensorType"},
+    /* Temperature Measurement (Flow, Relative Humidity, Leaf Wetness, Soil Moisture Measurement) */
+    {MATTER_NAME_KEY(0x0402, 0x0000), "MeasuredValue"},
+    {MATTER_NAME_KEY(0x0402, 0x0001), "MinMeasuredValue"},
+    {MATTER_NAME_KEY(0x0402, 0x0002), "MaxMeasuredValue"},
+    {MATTER_NAME_KEY(0x0402, 0x0003), "Tolerance"},
+    /* Pressure Measurement */
+    {MATTER_NAME_KEY(0x0403, 0x0000), "MeasuredValue"},
+    {MATTER_NAME_KEY(0x0403, 0x0001), "MinMeasuredValue"},
+    {MATTER_NAME_KEY(0x0403, 0x0002), "MaxMeasuredValue"},
+    {MATTER_NAME_KEY(0x0403, 0x0003), "Tolerance"},
+    {MATTER_NAME_KEY(0x0403, 0x0010), "ScaledValue"},
+    {MATTER_NAME_KEY(0x0403, 0x0011), "MinScaledValue"},
+    {MATTER_NAME_KEY(0x0403, 0x0012), "MaxScaledValue"},
+    {MATTER_NAME_KEY(0x0403, 0x0013), "ScaledTolerance"},
+    {MATTER_NAME_KEY(0x0403, 0x0014), "Scale"},
+    /* Occupancy Sensing */
+    {MATTER_NAME_KEY(0x0406, 0x0000), "Occupancy"},
+    {MATTER_NAME_KEY(0x0406, 0x0001), "OccupancySensorType"},
+    {MATTER_NAME_KEY(0x0406, 0x0002), "OccupancySensorTypeBitmap"},
+    {MATTER_NAME_KEY(0x0406, 0x0010), "PIROccupiedToUnoccupiedDelay"},
+    {MATTER_NAME_KEY(0x0406, 0x0011), "PIRUnoccupiedToOccupiedDelay"},
+    {MATTER_NAME_KEY(0x0406, 0x0012), "PIRUnoccupiedToOccupiedThreshold"},
+    {MATTER_NAME_KEY(0x0406, 0x0020), "UltrasonicOccupiedToUnoccupiedDelay"},
+    {MATTER_NAME_KEY(0x0406, 0x0021), "UltrasonicUnoccupiedToOccupiedDelay"},
+    {MATTER_NAME_KEY(0x0406, 0x0022), "UltrasonicUnoccupiedToOccupiedThreshold"},
+    {MATTER_NAME_KEY(0x0406, 0x0030), "PhysicalContactOccupiedToUnoccupiedDelay"},
+    {MATTER_NAME_KEY(0x0406, 0x0031), "PhysicalContactUnoccupiedToOccupiedDelay"},
+    {MATTER_NAME_KEY(0x0406, 0x0032), "PhysicalContactUnoccupiedToOccupiedThreshold"},
+};
+
+// clusters sharing the attribute set of another cluster
+typedef struct matter_cluster_alias {
+    uint32_t cluster_id;
+    uint32_t alias_id;
+} matter_cluster_alias_t;
+
+static constexpr matter_cluster_alias_t attribute_cluster_alias[] = {
+    {0x0039, 0x0028},
+    {0x0404, 0x0402},
+    {0x0405, 0x0402},
+    {0x0407, 0x0402},
+    {0x0408, 0x0402},
+};
+
+static constexpr matter_name_entry_t command_names[] = {
+    /* Identify */
+    {MATTER_NAME_KEY(0x0003, 0x00), "Itentify"},
+    {MATTER_NAME_KEY(0x0003, 0x01), "IdentifyQuery"},
+    {MATTER_NAME_KEY(0x0003, 0x40), "TriggerEffect"},
+    /* On/Off */
+    {MATTER_NAME_KEY(0x0006, 0x00), "Off"},
+    {MATTER_NAME_KEY(0x0006, 0x01), "On"},
+    {MATTER_NAME_KEY(0x0006, 0x02), "Toggle"},
+    {MATTER_NAME_KEY(0x0006, 0x40), "OffWithEffect"},
+    {MATTER_NAME_KEY(0x0006, 0x41), "OnWithRecallGlobalScene"},
+    {MATTER_NAME_KEY(0x0006, 0x42), "OnWithTimedOff"},
+    /* Level Control */
+    {MATTER_NAME_KEY(0x0008, 0x00), "MoveToLevel"},
+    {MATTER_NAME_KEY(0x0008, 0x01), "Move"},
+    {MATTER_NAME_KEY(0x0008, 0x02), "Step"},
+    {MATTER_NAME_KEY(0x0008, 0x03), "Stop"},
+    {MATTER_NAME_KEY(0x0008, 0x04), "MoveToLevelWithOnOff"},
+    {MATTER_NAME_KEY(0x0008, 0x05), "MoveWithOnOff"},
+    {MATTER_NAME_KEY(0x0008, 0x06), "StepWithOnOff"},
+    {MATTER_NAME_KEY(0x0008, 0x07), "StopWithOnOff"},
+    {MATTER_NAME_KEY(0x0008, 0x08), "MoveToClosestFrequency"},
+    /* Color Control */
+    {MATTER_NAME_KEY(0x0300, 0x00), "MoveToHue"},
+    {MATTER_NAME_KEY(0x0300, 0x01), "MoveHue"},
+    {MATTER_NAME_KEY(0x0300, 0x02), "StepHue"},
+    {MATTER_NAME_KEY(0x0300, 0x03), "MoveToSaturation"},
+    {MATTER_NAME_KEY(0x0300, 0x04), "MoveSaturation"},
+    {MATTER_NAME_KEY(0x0300, 0x05), "StepSaturation"},
+    {MATTER_NAME_KEY(0x0300, 0x06), "MoveToHueAndSaturation"},
+    {MATTER_NAME_KEY(0x0300, 0x07), "MoveToColor"},
+    {MATTER_NAME_KEY(0x0300, 0x08), "MoveColor"},
+    {MATTER_NAME_KEY(0x0300, 0x09), "StepColor"},
+    {MATTER_NAME_KEY(0x0300, 0x0A), "MoveToColorTemperature"},
+    {MATTER_NAME_KEY(0x0300, 0x40), "EnhancedMoveToHue"},
+    {MATTER_NAME_KEY(0x0300, 0x41), "EnhancedMoveHue"},
+    {MATTER_NAME_KEY(0x0300, 0x42), "EnhancedStepHue"},
+    {MATTER_NAME_KEY(0x0300, 0x43), "EnhancedMoveToHueAndSaturation"},
+    {MATTER_NAME_KEY(0x0300, 0x44), "ColorLoopSet"},
+    {MATTER_NAME_KEY(0x0300, 0x47), "StopMoveStep"},
+    {MATTER_NAME_KEY(0x0300, 0x4B), "MoveColorTemperature"},
+    {MATTER_NAME_KEY(0x0300, 0x4C), "StepColorTemperature"},
+};
+
+template <size_t N>
+static constexpr bool is_sorted_table(const matter_name_entry_t (&table)[N])
+{
+    for (size_t i = 1; i < N; i++) {
+        if (table[i - 1].id >= table[i].id)
+            return false;
+    }
+    return true;
+}
+
+static_assert(is_sorted_table(device_type_names), "device type names must be sorted by id");
+static_assert(is_sorted_table(cluster_names), "cluster names must be sorted by id");
+static_assert(is_sorted_table(global_attribute_names), "global attribute names must be sorted by id");
+static_assert(is_sorted_table(attribute_names), "attribute names must be sorted by key");
+static_assert(is_sorted_table(command_names), "command names must be sorted by key");
+
+template <size_t N>
+static const char* find_name(const matter_name_entry_t (&table)[N], uint32_t id)
+{
+    size_t lo = 0;
+    size_t hi = N;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (table[mid].id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < N && table[lo].id == id) ? table[lo].name : "?";
+}
+
+const char* get_matter_device_name(uint16_t device_id)
+{
+    return find_name(device_type_names, device_id);
+}
+
+const char* get_matter_cluster_name(uint32_t cluster_id)
+{
+    return find_name(cluster_names, cluster_id);
+}
+
+const char* get_matter_attribute_name(uint32_t cluster_id, uint32_t attribute_id)
+{
+    const char *name = find_name(global_attribute_names, attribute_id);
+    if (name[0] != '?')
+        return name;
+    if (cluster_id > 0xFFFF || attribute_id > 0xFFFF)
+        return "?";
+
+    for (auto & alias : attribute_cluster_alias) {
+        if (alias.cluster_id == cluster_id) {
+            cluster_id = alias.alias_id;
+            break;
+        }
+    }
+    return find_name(attribute_names, MATTER_NAME_KEY(cluster_id, attribute_id));
+}
+
+const char* get_matter_command_name(uint32_t cluster_id, uint32_t command_id)
+{
+    if (cluster_id > 0xFFFF || command_id > 0xFFFF)
+        return "?";
+    return find_name(command_names, MATTER_NAME_KEY(cluster_id, command_id));
+}
+#else
+// name tables compiled out (CONFIG_APP_MATTER_NAME_TABLE)
+const char* get_matter_device_name(uint16_t device_id)
+{
+    return "?";
+}
+
+const char* get_matter_cluster_name(uint32_t cluster_id)
+{
+    return "?";
+}
+
+const char* get_matter_attribute_name(uint32_t cluster_id, uint32_t attribute_id)
+{
+    return "?";
+}
+
+const char* get_matter_command_name(uint32_t cluster_id, uint32_t command_id)
+{
+    return "?";
+}
+#endif
@@ -0,0 +1,169 @@
+#include "metrics.h"
+#include "logger.h"
+
+static const char *counter_name[MetricCounterCount] = {
+    "sample count",
+    "ranging steps",
+    "saturation recovery",
+    "clipped samples",
+    "burst overrun",
+    "i2c transaction",
+    "i2c error",
+    "attribute report",
+    "attribute report failed",
+    "sample failed",
+    "i2c retry",
+    "i2c bus recovery",
+    "i2c breaker open",
+    "i2c breaker rejected",
+    "sample dropped"
+};
+
+static const char *gauge_name[MetricGaugeCount] = {
+    "heap min free",
+    "heap free",
+    "task stack min free",
+    "boot time to first report",
+    "sample period"
+};
+
+static const char *histogram_name[MetricHistogramCount] = {
+    "sample latency (ms)",
+    "i2c latency (us)",
+    "sample jitter (us)"
+};
+
+static const uint32_t histogram_base[MetricHistogramCount] = {
+    25,     // 25, 50, ..., 1600 ms
+    100,    // 100, 200, ..., 6400 us
+    500     // 500, 1000, ..., 32000 us
+};
+
+CMetrics* CMetrics::_instance = nullptr;
+
+CMetrics::CMetrics()
+{
+    reset();
+    for (int i = 0; i < MetricGaugeCount; i++) {
+        m_gauges[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+CMetrics::~CMetrics()
+{
+}
+
+CMetrics* CMetrics::Instance()
+{
+    if (!_instance) {
+        _instance = new CMetrics();
+    }
+
+    return _instance;
+}
+
+void CMetrics::increment(eMetricCounter type, uint32_t value/*=1*/)
+{
+    if (type >= MetricCounterCount)
+        return;
+    m_counters[type].fetch_add(value, std::memory_order_relaxed);
+}
+
+void CMetrics::set_gauge(eMetricGauge type, uint32_t value)
+{
+    if (type >= MetricGaugeCount)
+        return;
+    m_gauges[type].store(value, std::memory_order_relaxed);
+}
+
+void CMetrics::record(eMetricHistogram type, uint32_t value)
+{
+    if (type >= MetricHistogramCount)
+        return;
+
+    // logarithmic buckets: 0 for [0, base), n for [base * 2^(n-1), base * 2^n), last bucket unbounded
+    int idx = 0;
+    uint32_t bound = histogram_base[type];
+    while (idx < METRIC_HISTOGRAM_BUCKET_COUNT - 1 && value >= bound) {
+        idx++;
+        bound <<= 1;
+    }
+    m_histogram_buckets[type][idx].fetch_add(1, std::memory_order_relaxed);
+    m_histogram_sum[type].fetch_add(value, std::memory_order_relaxed);
+
+    uint32_t prev = m_histogram_max[type].load(std::memory_order_relaxed);
+    while (value > prev && !m_histogram_max[type].compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint32_t CMetrics::get_counter(eMetricCounter type)
+{
+    if (type >= MetricCounterCount)
+        return 0;
+    return m_counters[type].load(std::memory_order_relaxed);
+}
+
+uint32_t CMetrics::get_gauge(eMetricGauge type)
+{
+    if (type >= MetricGaugeCount)
+        return 0;
+    return m_gauges[type].load(std::memory_order_relaxed);
+}
+
+bool CMetrics::get_histogram(eMetricHistogram type, metric_histogram_t *histogram)
+{
+    if (type >= MetricHistogramCount || !histogram)
+        return false;
+
+    histogram->base = histogram_base[type];
+    histogram->count = 0;
+    for (int i = 0; i < METRIC_HISTOGRAM_BUCKET_COUNT; i++) {
+        histogram->buckets[i] = m_histogram_buckets[type][i].load(std::memory_order_relaxed);
+        histogram->count += histogram->buckets[i];
+    }
+    histogram->sum = m_histogram_sum[type].load(std::memory_order_relaxed);
+    histogram->max = m_histogram_max[type].load(std::memory_order_relaxed);
+    return true;
+}
+
+void CMetrics::reset()
+{
+    // gauges are not reset (sampled values)
+    for (int i = 0; i < MetricCounterCount; i++) {
+        m_counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < MetricHistogramCount; i++) {
+        for (int j = 0; j < METRIC_HISTOGRAM_BUCKET_COUNT; j++) {
+            m_histogram_buckets[i][j].store(0, std::memory_order_relaxed);
+        }
+        m_histogram_sum[i].store(0, std::memory_order_relaxed);
+        m_histogram_max[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void CMetrics::print_info()
+{
+    GetLogger(eLogType::Info)->Log("Runtime Metrics");
+    for (int i = 0; i < MetricCounterCount; i++) {
+        GetLoggerM(eLogType::Info)->Log("%s: %u", counter_name[i], get_counter((eMetricCounter)i));
+    }
+    for (int i = 0; i < MetricGaugeCount; i++) {
+        GetLoggerM(eLogType::Info)->Log("%s: %u", gauge_name[i], get_gauge((eMetricGauge)i));
+    }
+
+    metric_histogram_t histogram;
+    for (int i = 0; i < MetricHistogramCount; i++) {
+        get_histogram((eMetricHistogram)i, &histogram);
+        GetLoggerM(eLogType::Info)->Log("%s: count %u, mean %.1f, max %u", histogram_name[i], histogram.count,
+            histogram.count ? (double)histogram.sum / (double)histogram.count : 0., histogram.max);
+        uint32_t bound = histogram.base;
+        for (int j = 0; j < METRIC_HISTOGRAM_BUCKET_COUNT; j++) {
+            if (j < METRIC_HISTOGRAM_BUCKET_COUNT - 1) {
+                GetLoggerM(eLogType::Info)->Log("  < %u: %u", bound, histogram.buckets[j]);
+            } else {
+                GetLoggerM(eLogType::Info)->Log("  >= %u: %u", bound >> 1, histogram.buckets[j]);
+            }
+            bound <<= 1;
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#include "powermanager.h"
+#include "logger.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "driver/uart.h"
+#include <stdio.h>
+
+#define UART_WAKEUP_THRESHOLD   3   // rx positive edges (hardware minimum)
+
+static const char *lock_type_name[PmLockTypeCount] = {
+    "i2c transaction",
+    "sensor integration",
+    "console"
+};
+
+CPowerManager* CPowerManager::_instance = nullptr;
+
+CPowerManager::CPowerManager()
+{
+    m_initialized = false;
+    m_init_time_us = 0;
+    m_spinlock = portMUX_INITIALIZER_UNLOCKED;
+    m_lock_apb_freq_max = nullptr;
+    for (int i = 0; i < PmLockTypeCount; i++) {
+        m_lock_no_light_sleep[i] = nullptr;
+        m_lock_depth[i] = 0;
+        m_lock_count[i] = 0;
+        m_lock_acquired_us[i] = 0;
+        m_lock_held_us[i] = 0;
+    }
+}
+
+CPowerManager::~CPowerManager()
+{
+}
+
+CPowerManager* CPowerManager::Instance()
+{
+    if (!_instance) {
+        _instance = new CPowerManager();
+    }
+
+    return _instance;
+}
+
+bool CPowerManager::initialize(int max_freq_mhz, int min_freq_mhz, bool light_sleep_enable)
+{
+    m_init_time_us = esp_timer_get_time();
+#if CONFIG_PM_ENABLE
+    esp_err_t ret;
+    esp_pm_config_t pm_config;
+    pm_config.max_freq_mhz = max_freq_mhz;
+    pm_config.min_freq_mhz = min_freq_mhz;
+    pm_config.light_sleep_enable = light_sleep_enable;
+    ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to configure power management (ret: %d)", ret);
+        return false;
+    }
+
+    ret = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "i2c_apb", &m_lock_apb_freq_max);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to create APB frequency lock (ret: %d)", ret);
+        return false;
+    }
+    ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "i2c_nls", &m_lock_no_light_sleep[I2CTransaction]);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to create i2c no light sleep lock (ret: %d)", ret);
+        return false;
+    }
+    ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "sensor_nls", &m_lock_no_light_sleep[SensorIntegration]);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to create sensor no light sleep lock (ret: %d)", ret);
+        return false;
+    }
+    ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "console_nls", &m_lock_no_light_sleep[ConsoleActive]);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to create console no light sleep lock (ret: %d)", ret);
+        return false;
+    }
+
+    m_initialized = true;
+    GetLogger(eLogType::Info)->Log("Initialized (cpu freq: %d ~ %d MHz, light sleep: %d)", min_freq_mhz, max_freq_mhz, light_sleep_enable);
+    return true;
+#else
+    GetLogger(eLogType::Warning)->Log("Power management is disabled (CONFIG_PM_ENABLE)");
+    return false;
+#endif
+}
+
+void CPowerManager::acquire(ePmLockType type)
+{
+    if (type >= PmLockTypeCount)
+        return;
+
+    if (m_initialized) {
+        if (type == I2CTransaction) {
+            esp_pm_lock_acquire(m_lock_apb_freq_max);
+        }
+        esp_pm_lock_acquire(m_lock_no_light_sleep[type]);
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&m_spinlock);
+    if (m_lock_depth[type]++ == 0) {
+        m_lock_acquired_us[type] = now_us;
+    }
+    m_lock_count[type]++;
+    portEXIT_CRITICAL(&m_spinlock);
+}
+
+void CPowerManager::release(ePmLockType type)
+{
+    if (type >= PmLockTypeCount)
+        return;
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&m_spinlock);
+    if (m_lock_depth[type] > 0 && --m_lock_depth[type] == 0) {
+        m_lock_held_us[type] += now_us - m_lock_acquired_us[type];
+    }
+    portEXIT_CRITICAL(&m_spinlock);
+
+    if (m_initialized) {
+        esp_pm_lock_release(m_lock_no_light_sleep[type]);
+        if (type == I2CTransaction) {
+            esp_pm_lock_release(m_lock_apb_freq_max);
+        }
+    }
+}
+
+bool CPowerManager::enable_uart_wakeup(int uart_num)
+{
+#if CONFIG_PM_ENABLE
+    esp_err_t ret = uart_set_wakeup_threshold((uart_port_t)uart_num, UART_WAKEUP_THRESHOLD);
+    if (ret == ESP_OK) {
+        ret = esp_sleep_enable_uart_wakeup(uart_num);
+    }
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to enable uart%d wake-up (ret: %d)", uart_num, ret);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CPowerManager::print_statistics()
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t elapsed_us = now_us - m_init_time_us;
+    if (elapsed_us <= 0)
+        elapsed_us = 1;
+
+    GetLogger(eLogType::Info)->Log("Power Management Statistics (enabled: %d)", m_initialized);
+    for (int i = 0; i < PmLockTypeCount; i++) {
+        portENTER_CRITICAL(&m_spinlock);
+        uint32_t count = m_lock_count[i];
+        int64_t held_us = m_lock_held_us[i];
+        if (m_lock_depth[i] > 0) {
+            held_us += now_us - m_lock_acquired_us[i];
+        }
+        portEXIT_CRITICAL(&m_spinlock);
+        GetLoggerM(eLogType::Info)->Log("%s: acquired %u times, held %lld ms (%.2f %%)",
+            lock_type_name[i], count, held_us / 1000, 100.f * (float)held_us / (float)elapsed_us);
+    }
+#if CONFIG_PM_ENABLE
+    // lock list, per power mode time accounting only with CONFIG_PM_PROFILING (opt-in)
+    esp_pm_dump_locks(stdout);
+#endif
+}
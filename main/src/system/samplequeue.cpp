@@ -0,0 +1,49 @@
+#include "samplequeue.h"
+#include "metrics.h"
+
+CSampleQueue::CSampleQueue()
+{
+    m_head = 0;
+    m_tail = 0;
+}
+
+CSampleQueue::~CSampleQueue()
+{
+}
+
+bool CSampleQueue::push(const report_sample_t *sample)
+{
+    if (!sample)
+        return false;
+
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+    uint32_t tail = m_tail.load(std::memory_order_acquire);
+    if (head - tail >= SAMPLE_QUEUE_LENGTH) {
+        // consumer is behind (matter context busy), back-pressure is counted not waited
+        GetMetrics()->increment(MetricSampleDropped);
+        return false;
+    }
+    m_buffer[head % SAMPLE_QUEUE_LENGTH] = *sample;
+    m_head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool CSampleQueue::pop(report_sample_t *sample)
+{
+    uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    uint32_t head = m_head.load(std::memory_order_acquire);
+    if (head == tail)
+        return false;
+
+    if (sample)
+        *sample = m_buffer[tail % SAMPLE_QUEUE_LENGTH];
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+size_t CSampleQueue::get_count()
+{
+    return (size_t)(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+}
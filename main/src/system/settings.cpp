@@ -0,0 +1,427 @@
+#include "settings.h"
+#include "logger.h"
+#include "definition.h"
+#include "veml7700.h"
+#include <nvs_flash.h>
+#include <nvs.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TASK_SETTINGS_STACK_DEPTH   3072
+#define TASK_SETTINGS_PRIORITY      1
+#define SETTINGS_COMMIT_MAX_DELAY_MS    6 * SETTINGS_COMMIT_DELAY_MS    // upper bound while changes keep coming
+
+CSettings* CSettings::_instance = nullptr;
+
+CSettings::CSettings()
+{
+    m_initialized = false;
+    m_mutex = xSemaphoreCreateMutex();
+    m_task_commit_handle = nullptr;
+    m_revision = 0;
+    m_committed_revision = 0;
+    m_commit_count = 0;
+    m_last_commit_result = ESP_OK;
+
+    memset(m_cache, 0, sizeof(m_cache));
+    m_cache[0].version = SETTINGS_VERSION;
+    m_cache[0].length = sizeof(settings_blob_t);
+    set_default(&m_cache[0].sensor);
+    CLuxCalibration::set_default(&m_cache[0].calibration);
+    set_default(&m_cache[0].sampling);
+}
+
+CSettings::~CSettings()
+{
+}
+
+CSettings* CSettings::Instance()
+{
+    if (!_instance) {
+        _instance = new CSettings();
+    }
+
+    return _instance;
+}
+
+bool CSettings::initialize()
+{
+    settings_blob_t blob;
+    bool imported = false;
+    bool current = load(&blob);
+    if (!current) {
+        imported = import_legacy_calibration(&blob);
+    }
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    write(&blob);
+    if (current) {
+        m_committed_revision = m_revision.load();
+    }
+    xSemaphoreGive(m_mutex);
+    m_initialized = true;
+
+    if (imported && commit()) {
+        // legacy standalone calibration blob is not needed any more
+        nvs_handle_t handle;
+        if (nvs_open(CALIB_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+            nvs_erase_key(handle, CALIB_NVS_KEY);
+            nvs_commit(handle);
+            nvs_close(handle);
+        }
+    }
+
+    xTaskCreate(task_commit_function, "TASK_SETTINGS", TASK_SETTINGS_STACK_DEPTH, this, TASK_SETTINGS_PRIORITY, &m_task_commit_handle);
+    if (m_task_commit_handle && m_committed_revision != m_revision) {
+        xTaskNotifyGive(m_task_commit_handle);
+    }
+
+    GetLogger(eLogType::Info)->Log("Initialized (version: %u, %s)", SETTINGS_VERSION, current ? "loaded" : "default or migrated");
+    return true;
+}
+
+void CSettings::read(settings_blob_t *blob)
+{
+    // lock free: writer fills the inactive cache then publishes it, copy again if a write was published meanwhile
+    uint32_t revision;
+    do {
+        revision = m_revision.load(std::memory_order_acquire);
+        *blob = m_cache[revision & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (m_revision.load(std::memory_order_relaxed) != revision);
+}
+
+void CSettings::write(const settings_blob_t *blob)
+{
+    // m_mutex must be held
+    uint32_t revision = m_revision.load(std::memory_order_relaxed) + 1;
+    m_cache[revision & 1] = *blob;
+    m_revision.store(revision, std::memory_order_release);
+    if (m_task_commit_handle) {
+        xTaskNotifyGive(m_task_commit_handle);
+    }
+}
+
+bool CSettings::load(settings_blob_t *blob)
+{
+    memset(blob, 0, sizeof(settings_blob_t));
+    blob->version = SETTINGS_VERSION;
+    blob->length = sizeof(settings_blob_t);
+    set_default(&blob->sensor);
+    CLuxCalibration::set_default(&blob->calibration);
+    set_default(&blob->sampling);
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Warning)->Log("No settings, use default (ret: %d)", ret);
+        return false;
+    }
+
+    size_t length = 0;
+    ret = nvs_get_blob(handle, SETTINGS_NVS_KEY, nullptr, &length);
+    if (ret != ESP_OK || length == 0) {
+        nvs_close(handle);
+        GetLogger(eLogType::Warning)->Log("No settings, use default (ret: %d)", ret);
+        return false;
+    }
+
+    // blob written by newer firmware may be larger than settings_blob_t
+    uint8_t *data = (uint8_t *)malloc(length);
+    if (!data) {
+        nvs_close(handle);
+        return false;
+    }
+    ret = nvs_get_blob(handle, SETTINGS_NVS_KEY, data, &length);
+    nvs_close(handle);
+
+    bool result = false;
+    if (ret == ESP_OK) {
+        result = migrate(data, length, blob);
+    } else {
+        GetLogger(eLogType::Warning)->Log("Failed to read settings, use default (ret: %d)", ret);
+    }
+    free(data);
+    return result;
+}
+
+bool CSettings::migrate(const uint8_t *data, size_t length, settings_blob_t *blob)
+{
+    uint16_t version;
+    if (length < offsetof(settings_blob_t, sensor)) {
+        GetLogger(eLogType::Warning)->Log("Invalid settings (length: %u), use default", length);
+        return false;
+    }
+    memcpy(&version, data, sizeof(version));
+    if (version == 0) {
+        GetLogger(eLogType::Warning)->Log("Invalid settings version, use default");
+        return false;
+    }
+    if (version > SETTINGS_VERSION) {
+        GetLogger(eLogType::Warning)->Log("Settings written by newer firmware (version: %u), unknown fields are dropped", version);
+    }
+
+    // append only layout: fields beyond the stored length keep default value
+    memcpy(blob, data, MIN(length, sizeof(settings_blob_t)));
+    // conversion of fields whose meaning changed goes here (switch on version, fall through to the newest)
+
+    bool current = version == SETTINGS_VERSION && length == sizeof(settings_blob_t);
+    if (!current) {
+        GetLogger(eLogType::Info)->Log("Settings migrated (version: %u -> %u, length: %u -> %u)",
+            version, SETTINGS_VERSION, length, sizeof(settings_blob_t));
+    }
+    blob->version = SETTINGS_VERSION;
+    blob->length = sizeof(settings_blob_t);
+
+    // calibration section is validated by CLuxCalibration::load()
+    if (!validate(&blob->sensor)) {
+        GetLogger(eLogType::Warning)->Log("Invalid sensor settings, use default");
+        set_default(&blob->sensor);
+        current = false;
+    }
+    if (!validate(&blob->sampling)) {
+        GetLogger(eLogType::Warning)->Log("Invalid sampling settings, use default");
+        set_default(&blob->sampling);
+        current = false;
+    }
+
+    return current;
+}
+
+bool CSettings::import_legacy_calibration(settings_blob_t *blob)
+{
+    nvs_handle_t handle;
+    if (nvs_open(CALIB_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+        return false;
+
+    calibration_data_t data;
+    size_t length = sizeof(data);
+    esp_err_t ret = nvs_get_blob(handle, CALIB_NVS_KEY, &data, &length);
+    nvs_close(handle);
+    if (ret != ESP_OK || length != sizeof(data))
+        return false;
+
+    blob->calibration = data;
+    GetLogger(eLogType::Info)->Log("Legacy calibration data imported");
+    return true;
+}
+
+bool CSettings::commit()
+{
+    if (!m_initialized)
+        return false;
+
+    uint32_t revision = m_revision.load(std::memory_order_acquire);
+    if (revision == m_committed_revision)
+        return true;
+
+    settings_blob_t blob;
+    read(&blob);
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, SETTINGS_NVS_KEY, &blob, sizeof(blob));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    m_last_commit_result = ret;
+    if (ret != ESP_OK) {
+        GetLogger(eLogType::Error)->Log("Failed to commit settings (ret: %d)", ret);
+        return false;
+    }
+
+    // blob may be newer than revision (write published after the load above), committed again next time at most
+    m_committed_revision = revision;
+    m_commit_count++;
+    return true;
+}
+
+void CSettings::task_commit_function(void *param)
+{
+    CSettings *obj = static_cast<CSettings *>(param);
+    TickType_t first_change_tick;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // debounce: wait until no change for SETTINGS_COMMIT_DELAY_MS (bounded by SETTINGS_COMMIT_MAX_DELAY_MS)
+        first_change_tick = xTaskGetTickCount();
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SETTINGS_COMMIT_DELAY_MS)) > 0) {
+            if (xTaskGetTickCount() - first_change_tick >= pdMS_TO_TICKS(SETTINGS_COMMIT_MAX_DELAY_MS))
+                break;
+        }
+        obj->commit();
+    }
+}
+
+void CSettings::set_default(sensor_settings_t *settings)
+{
+    if (!settings)
+        return;
+    settings->period_ms = SENSOR_DEFAULT_PERIOD_MS;
+    settings->ranging_policy = RangingAuto;
+    settings->fixed_gain = VEML7700_GAIN_1_8;
+    settings->fixed_integ_time = VEML7700_IT_100MS;
+    settings->power_saving_mode = 0;
+    settings->deadband_percent = 0.f;
+    settings->filter_alpha = 1.f;
+}
+
+bool CSettings::validate(const sensor_settings_t *settings)
+{
+    if (!settings)
+        return false;
+    if (settings->period_ms < SENSOR_MIN_PERIOD_MS || settings->period_ms > SENSOR_MAX_PERIOD_MS)
+        return false;
+    if (settings->ranging_policy >= RangingPolicyCount)
+        return false;
+    if (settings->fixed_gain > VEML7700_GAIN_1_4)
+        return false;
+    switch (settings->fixed_integ_time) {
+    case VEML7700_IT_25MS:
+    case VEML7700_IT_50MS:
+    case VEML7700_IT_100MS:
+    case VEML7700_IT_200MS:
+    case VEML7700_IT_400MS:
+    case VEML7700_IT_800MS:
+        break;
+    default:
+        return false;
+    }
+    if (settings->power_saving_mode > 4)
+        return false;
+    if (!(settings->deadband_percent >= 0.f && settings->deadband_percent <= 100.f))
+        return false;
+    if (!(settings->filter_alpha > 0.f && settings->filter_alpha <= 1.f))
+        return false;
+    return true;
+}
+
+void CSettings::set_default(sampling_settings_t *sampling)
+{
+    if (!sampling)
+        return;
+    sampling->adaptive = 0;     // fixed period (sensor settings) unless enabled
+    sampling->min_period_ms = SENSOR_MIN_PERIOD_MS;
+    sampling->max_period_ms = SAMPLING_DEFAULT_MAX_PERIOD_MS;
+    sampling->change_percent = 5.f;
+}
+
+bool CSettings::validate(const sampling_settings_t *sampling)
+{
+    if (!sampling)
+        return false;
+    if (sampling->adaptive > 1)
+        return false;
+    if (sampling->min_period_ms < SENSOR_MIN_PERIOD_MS || sampling->max_period_ms > SENSOR_MAX_PERIOD_MS)
+        return false;
+    if (sampling->min_period_ms > sampling->max_period_ms)
+        return false;
+    if (!(sampling->change_percent > 0.f && sampling->change_percent <= 100.f))
+        return false;
+    return true;
+}
+
+void CSettings::get(sensor_settings_t *settings)
+{
+    if (!settings)
+        return;
+    settings_blob_t blob;
+    read(&blob);
+    *settings = blob.sensor;
+}
+
+bool CSettings::set(const sensor_settings_t *settings)
+{
+    if (!validate(settings)) {
+        GetLogger(eLogType::Error)->Log("Invalid sensor settings");
+        return false;
+    }
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    settings_blob_t blob = m_cache[m_revision.load(std::memory_order_relaxed) & 1];
+    blob.sensor = *settings;
+    write(&blob);
+    xSemaphoreGive(m_mutex);
+    return true;
+}
+
+void CSettings::get_calibration(calibration_data_t *calibration)
+{
+    if (!calibration)
+        return;
+    settings_blob_t blob;
+    read(&blob);
+    *calibration = blob.calibration;
+}
+
+bool CSettings::set_calibration(const calibration_data_t *calibration)
+{
+    if (!calibration)
+        return false;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    settings_blob_t blob = m_cache[m_revision.load(std::memory_order_relaxed) & 1];
+    blob.calibration = *calibration;
+    write(&blob);
+    xSemaphoreGive(m_mutex);
+    return true;
+}
+
+void CSettings::get_sampling(sampling_settings_t *sampling)
+{
+    if (!sampling)
+        return;
+    settings_blob_t blob;
+    read(&blob);
+    *sampling = blob.sampling;
+}
+
+bool CSettings::set_sampling(const sampling_settings_t *sampling)
+{
+    if (!validate(sampling)) {
+        GetLogger(eLogType::Error)->Log("Invalid sampling settings");
+        return false;
+    }
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    settings_blob_t blob = m_cache[m_revision.load(std::memory_order_relaxed) & 1];
+    blob.sampling = *sampling;
+    write(&blob);
+    xSemaphoreGive(m_mutex);
+    return true;
+}
+
+void CSettings::reset()
+{
+    sensor_settings_t settings;
+    set_default(&settings);
+    set(&settings);
+    sampling_settings_t sampling;
+    set_default(&sampling);
+    set_sampling(&sampling);
+}
+
+void CSettings::print_info()
+{
+    const char *gain_name[] = {"1", "2", "1/8", "1/4"};
+    sensor_settings_t settings;
+    get(&settings);
+    sampling_settings_t sampling;
+    get_sampling(&sampling);
+
+    GetLogger(eLogType::Info)->Log("Sensor Settings");
+    GetLoggerM(eLogType::Info)->Log("period: %u ms%s", settings.period_ms, sampling.adaptive ? " (not used while adaptive period is on)" : "");
+    GetLoggerM(eLogType::Info)->Log("adaptive period: %s (%u ~ %u ms, change: %g %%)",
+        sampling.adaptive ? "on" : "off", sampling.min_period_ms, sampling.max_period_ms, sampling.change_percent);
+    GetLoggerM(eLogType::Info)->Log("ranging: %s (fixed gain: %s, integration time reg: 0x%02X)",
+        settings.ranging_policy == RangingFixed ? "fixed" : "auto", gain_name[settings.fixed_gain & 0x03], settings.fixed_integ_time);
+    GetLoggerM(eLogType::Info)->Log("power saving mode: %u (0: disabled)", settings.power_saving_mode);
+    GetLoggerM(eLogType::Info)->Log("deadband: %g %%", settings.deadband_percent);
+    GetLoggerM(eLogType::Info)->Log("filter alpha: %g", settings.filter_alpha);
+    GetLoggerM(eLogType::Info)->Log("store: version %u, revision %u (committed: %u), %u commits, last result: %d",
+        SETTINGS_VERSION, m_revision.load(), m_committed_revision.load(), m_commit_count, m_last_commit_result);
+}
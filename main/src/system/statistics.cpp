@@ -0,0 +1,236 @@
+#include "statistics.h"
+#include <string.h>
+
+CLuxStatistics* CLuxStatistics::_instance = nullptr;
+
+CStatisticsWindow::CStatisticsWindow()
+{
+    m_hold_limit_us = STAT_DEFAULT_HOLD_LIMIT_US;
+    configure(STAT_BUCKET_COUNT);
+}
+
+void CStatisticsWindow::configure(uint32_t window_sec)
+{
+    if (window_sec < STAT_BUCKET_COUNT)
+        window_sec = STAT_BUCKET_COUNT;
+    m_window_sec = window_sec;
+    m_bucket_span_us = (int64_t)window_sec * 1000000LL / STAT_BUCKET_COUNT;
+    reset();
+}
+
+void CStatisticsWindow::reset()
+{
+    for (int i = 0; i < STAT_BUCKET_COUNT; i++) {
+        clear_bucket(&m_buckets[i]);
+    }
+    m_head = 0;
+    m_bucket_start_us = -1;
+    m_sum = 0.;
+    m_sum_sq = 0.;
+    m_integral = 0.;
+    m_duration_us = 0;
+    m_count = 0;
+    m_has_prev = false;
+    m_prev_value = 0.f;
+    m_prev_timestamp_us = 0;
+}
+
+void CStatisticsWindow::clear_bucket(bucket_t *bucket)
+{
+    bucket->min = 0.f;
+    bucket->max = 0.f;
+    bucket->sum = 0.;
+    bucket->sum_sq = 0.;
+    bucket->integral = 0.;
+    bucket->duration_us = 0;
+    bucket->count = 0;
+}
+
+void CStatisticsWindow::advance(int64_t timestamp_us)
+{
+    if (m_bucket_start_us < 0) {
+        m_bucket_start_us = timestamp_us;
+        return;
+    }
+
+    int64_t elapsed = (timestamp_us - m_bucket_start_us) / m_bucket_span_us;
+    if (elapsed <= 0)
+        return;
+
+    m_bucket_start_us += elapsed * m_bucket_span_us;
+    if (elapsed > STAT_BUCKET_COUNT)
+        elapsed = STAT_BUCKET_COUNT;
+    for (int64_t i = 0; i < elapsed; i++) {
+        m_head = (m_head + 1) % STAT_BUCKET_COUNT;
+        bucket_t *oldest = &m_buckets[m_head];
+        m_sum -= oldest->sum;
+        m_sum_sq -= oldest->sum_sq;
+        m_integral -= oldest->integral;
+        m_duration_us -= oldest->duration_us;
+        m_count -= oldest->count;
+        clear_bucket(oldest);
+    }
+
+    if (m_count == 0) {
+        // avoid accumulated rounding error when window becomes empty (held time of a gap goes with it)
+        for (int i = 0; i < STAT_BUCKET_COUNT; i++) {
+            clear_bucket(&m_buckets[i]);
+        }
+        m_sum = 0.;
+        m_sum_sq = 0.;
+        m_integral = 0.;
+        m_duration_us = 0;
+    }
+}
+
+void CStatisticsWindow::set_hold_limit(int64_t hold_limit_us)
+{
+    m_hold_limit_us = hold_limit_us;
+}
+
+void CStatisticsWindow::integrate(float value, int64_t from_us, int64_t to_us)
+{
+    // walk back from the head bucket, the part of the interval before the oldest bucket has slid out
+    int64_t seg_start = m_bucket_start_us;
+    int64_t seg_end = to_us;
+    int index = m_head;
+    for (int i = 0; i < STAT_BUCKET_COUNT && seg_end > from_us; i++) {
+        int64_t start = MAX(seg_start, from_us);
+        if (seg_end > start) {
+            int64_t dt_us = seg_end - start;
+            double area = (double)value * (double)dt_us;
+            m_buckets[index].integral += area;
+            m_buckets[index].duration_us += dt_us;
+            m_integral += area;
+            m_duration_us += dt_us;
+        }
+        seg_end = seg_start;
+        seg_start -= m_bucket_span_us;
+        index = (index + STAT_BUCKET_COUNT - 1) % STAT_BUCKET_COUNT;
+    }
+}
+
+void CStatisticsWindow::push(float value, int64_t timestamp_us)
+{
+    advance(timestamp_us);
+    bucket_t *bucket = &m_buckets[m_head];
+
+    // zero-order hold of previous sample, split over the buckets the gap spans
+    // (gaps longer than the hold limit, e.g. sensor detached, are not integrated)
+    if (m_has_prev) {
+        int64_t dt_us = timestamp_us - m_prev_timestamp_us;
+        if (dt_us > 0 && dt_us <= m_hold_limit_us) {
+            integrate(m_prev_value, m_prev_timestamp_us, timestamp_us);
+        }
+    }
+    m_has_prev = true;
+    m_prev_value = value;
+    m_prev_timestamp_us = timestamp_us;
+
+    if (bucket->count == 0) {
+        bucket->min = value;
+        bucket->max = value;
+    } else {
+        if (value < bucket->min)
+            bucket->min = value;
+        if (value > bucket->max)
+            bucket->max = value;
+    }
+    bucket->sum += value;
+    bucket->sum_sq += (double)value * (double)value;
+    bucket->count++;
+    m_sum += value;
+    m_sum_sq += (double)value * (double)value;
+    m_count++;
+}
+
+bool CStatisticsWindow::get_result(int64_t timestamp_us, statistics_result_t *result)
+{
+    if (!result)
+        return false;
+
+    advance(timestamp_us);
+    memset(result, 0, sizeof(statistics_result_t));
+    result->window_sec = m_window_sec;
+    if (m_count == 0)
+        return false;
+
+    bool first = true;
+    for (int i = 0; i < STAT_BUCKET_COUNT; i++) {
+        bucket_t *bucket = &m_buckets[i];
+        if (bucket->count == 0)
+            continue;
+        if (first || bucket->min < result->min)
+            result->min = bucket->min;
+        if (first || bucket->max > result->max)
+            result->max = bucket->max;
+        first = false;
+    }
+
+    double mean = m_sum / (double)m_count;
+    double variance = m_sum_sq / (double)m_count - mean * mean;
+    result->count = m_count;
+    result->mean = (float)mean;
+    result->variance = variance > 0. ? (float)variance : 0.f;
+    result->time_weighted_mean = m_duration_us > 0 ? (float)(m_integral / (double)m_duration_us) : (float)mean;
+    result->integral = (float)(m_integral / 3.6e9);
+
+    return true;
+}
+
+CLuxStatistics::CLuxStatistics()
+{
+    const uint32_t window_sec_list[STAT_WINDOW_COUNT] = STAT_WINDOW_SEC_LIST;
+    for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+        m_windows[i].configure(window_sec_list[i]);
+    }
+}
+
+CLuxStatistics::~CLuxStatistics()
+{
+}
+
+CLuxStatistics* CLuxStatistics::Instance()
+{
+    if (!_instance) {
+        _instance = new CLuxStatistics();
+    }
+
+    return _instance;
+}
+
+bool CLuxStatistics::configure_window(int index, uint32_t window_sec)
+{
+    if (index < 0 || index >= STAT_WINDOW_COUNT)
+        return false;
+    m_windows[index].configure(window_sec);
+    return true;
+}
+
+void CLuxStatistics::set_hold_limit(int64_t hold_limit_us)
+{
+    for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+        m_windows[i].set_hold_limit(hold_limit_us);
+    }
+}
+
+void CLuxStatistics::reset()
+{
+    for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+        m_windows[i].reset();
+    }
+}
+
+void CLuxStatistics::push(float value, int64_t timestamp_us)
+{
+    for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+        m_windows[i].push(value, timestamp_us);
+    }
+}
+
+bool CLuxStatistics::get_result(int index, int64_t timestamp_us, statistics_result_t *result)
+{
+    if (index < 0 || index >= STAT_WINDOW_COUNT)
+        return false;
+    return m_windows[index].get_result(timestamp_us, result);
+}
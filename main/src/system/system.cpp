@@ -5,19 +5,40 @@
 #include <esp_chip_info.h>
 #include <esp_flash.h>
 #include <esp_app_desc.h>
+#include <esp_system.h>
 #include <app/server/Server.h>
+#include <platform/CHIPDeviceLayer.h>
 #include <esp_matter_providers.h>
-#include "cJSON.h"
 #include "util.h"
 #include "logger.h"
 #include "definition.h"
 #include "veml7700.h"
 #include "lightsensor.h"
+#include "powermanager.h"
+#include "console.h"
+#include "statistics.h"
+#include "history.h"
+#include "flicker.h"
+#include "calibration.h"
+#include "metrics.h"
+#include "customcluster.h"
+#include "trace.h"
+#include "settings.h"
+#include "boottimeline.h"
+#include "discovery.h"
+#include "samplequeue.h"
+#include "adaptivesampler.h"
 #include <math.h>
+#include <string.h>
 
-#define TASK_TIMER_STACK_DEPTH  3072
-#define TASK_TIMER_PRIORITY     5
-#define MEASURE_PERIOD_US       1 * 1000 * 1000
+#define TASK_TIMER_STACK_DEPTH  4096
+#define TASK_TIMER_PRIORITY     CONFIG_APP_SENSOR_TASK_PRIORITY
+#define TASK_WORKER_STACK_DEPTH 4096
+#define TASK_WORKER_PRIORITY    CONFIG_APP_WORKER_TASK_PRIORITY
+#define JOB_QUEUE_LENGTH        8
+#define TASK_SENSOR_INIT_STACK_DEPTH    3072
+#define TASK_SENSOR_INIT_PRIORITY       CONFIG_APP_SENSOR_TASK_PRIORITY
+#define SENSOR_INIT_TIMEOUT_MS          5000
 
 CSystem* CSystem::_instance = nullptr;
 bool CSystem::m_default_btn_pressed_long = false;
@@ -36,8 +57,21 @@ CSystem::CSystem()
     m_device_list.clear();
     m_keepalive = true;
     m_initialized = false;
+    m_flicker_integ_time_sec = 0.025f;
+    m_sensor_init_done = nullptr;
+    m_boot_sample_valid = false;
+    m_boot_sample_retained = false;
+    m_sensor_present = false;
+    m_sensor_attached = false;
+    m_sensor_missing_count = 0;
+    m_publish_scheduled = false;
+    m_first_reported = false;
 
-    xTaskCreate(task_timer_function, "TASK_TIMER", TASK_TIMER_STACK_DEPTH, this, TASK_TIMER_PRIORITY, &m_task_timer_handle);
+    m_task_worker_handle = nullptr;
+    m_job_queue = xQueueCreate(JOB_QUEUE_LENGTH, sizeof(system_job_t));
+
+    xTaskCreatePinnedToCore(task_timer_function, "TASK_TIMER", TASK_TIMER_STACK_DEPTH, this, TASK_TIMER_PRIORITY, &m_task_timer_handle, TASK_SENSOR_CORE_ID);
+    xTaskCreate(task_worker_function, "TASK_WORKER", TASK_WORKER_STACK_DEPTH, this, TASK_WORKER_PRIORITY, &m_task_worker_handle);
 }
 
 CSystem::~CSystem()
@@ -61,6 +95,7 @@ bool CSystem::initialize()
 {
     GetLogger(eLogType::Info)->Log("Start Initializing System");
  
+    GetBootTimeline()->begin(BootPhaseNvs);
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
@@ -70,17 +105,41 @@ bool CSystem::initialize()
         GetLogger(eLogType::Error)->Log("Failed to initialize nsv flash (%d)", ret);
         return false;
     }
+    GetBootTimeline()->end(BootPhaseNvs);
+
+    GetBootTimeline()->begin(BootPhasePowerManager);
+    if (!GetPowerManager()->initialize(PM_MAX_CPU_FREQ_MHZ, PM_MIN_CPU_FREQ_MHZ, PM_LIGHT_SLEEP_ENABLE)) {
+        GetLogger(eLogType::Warning)->Log("Failed to initialize power management");
+    }
+    GetBootTimeline()->end(BootPhasePowerManager);
 
+    GetBootTimeline()->begin(BootPhaseSettings);
+    if (!GetSettings()->initialize()) {
+        GetLogger(eLogType::Warning)->Log("Failed to initialize settings store");
+    }
+    GetBootTimeline()->end(BootPhaseSettings);
+
+    // sensor bring-up and the first conversion overlap matter startup
+    m_sensor_init_done = xSemaphoreCreateBinary();
+    if (!m_sensor_init_done || xTaskCreatePinnedToCore(task_sensor_init_function, "TASK_SENSOR_INIT", TASK_SENSOR_INIT_STACK_DEPTH, this, TASK_SENSOR_INIT_PRIORITY, nullptr, TASK_SENSOR_CORE_ID) != pdPASS) {
+        GetLogger(eLogType::Error)->Log("Failed to create sensor init task");
+        return false;
+    }
+
+    GetBootTimeline()->begin(BootPhaseButton);
     if (!init_default_button()) {
         GetLogger(eLogType::Warning)->Log("Failed to init default on-board button");
     }
+    GetBootTimeline()->end(BootPhaseButton);
 
-    m_i2c_master = GetI2CMaster();
-    m_i2c_master->initialize(I2C_PORT_NUM, GPIO_PIN_I2C_SCL, GPIO_PIN_I2C_SDA, I2C_MASTER_FREQ);
-
-    GetVeml7700Ctrl()->initialize(m_i2c_master);
+    GetBootTimeline()->begin(BootPhaseHistory);
+    if (!GetHistoryStore()->initialize()) {
+        GetLogger(eLogType::Warning)->Log("Failed to initialize history store");
+    }
+    GetBootTimeline()->end(BootPhaseHistory);
     
     // create matter root node
+    GetBootTimeline()->begin(BootPhaseRootNode);
     esp_matter::node::config_t node_config;
     snprintf(node_config.root_node.basic_information.node_label, sizeof(node_config.root_node.basic_information.node_label), PRODUCT_NAME);
     m_root_node = esp_matter::node::create(&node_config, matter_attribute_update_callback, matter_identification_callback);
@@ -89,8 +148,13 @@ bool CSystem::initialize()
         return false;
     }
     GetLogger(eLogType::Info)->Log("Root node (endpoint 0) added");
+    if (!matter_create_clus_metrics()) {
+        GetLogger(eLogType::Warning)->Log("Failed to create runtime metrics cluster");
+    }
+    GetBootTimeline()->end(BootPhaseRootNode);
 
     // start matter
+    GetBootTimeline()->begin(BootPhaseMatterStart);
     ret = esp_matter::start(matter_event_callback);
     if (ret != ESP_OK) {
         GetLogger(eLogType::Error)->Log("Failed to start matter (ret: %d)", ret);
@@ -99,16 +163,29 @@ bool CSystem::initialize()
     // prevent endpoint id increment when board reset
     matter_set_min_endpoint_id(1);
     GetLogger(eLogType::Info)->Log("Matter started");
+    GetBootTimeline()->end(BootPhaseMatterStart);
 
-    // add airquality sensor endpoint
-    CLightSensor *sensor = new CLightSensor();
-    if (sensor && sensor->matter_init_endpoint()) {
-        m_device_list.push_back(sensor);
-        sensor->set_min_measured_value(1);
-        sensor->set_max_measured_value((uint16_t)(10000. * log10(140000.) + 1.));
+    GetBootTimeline()->begin(BootPhaseConsole);
+    if (!register_console_commands()) {
+        GetLogger(eLogType::Warning)->Log("Failed to register console commands");
+    }
+    GetBootTimeline()->end(BootPhaseConsole);
+
+    // measurement task starts with the sample taken during bring-up; waits for the init task in any case
+    // (it owns the bus and m_sensor_present / m_boot_sample until it gives the semaphore, i2c deadlines bound it)
+    if (xSemaphoreTake(m_sensor_init_done, pdMS_TO_TICKS(SENSOR_INIT_TIMEOUT_MS)) != pdTRUE) {
+        GetLogger(eLogType::Warning)->Log("Sensor initialization is not finished in %d ms", SENSOR_INIT_TIMEOUT_MS);
+        xSemaphoreTake(m_sensor_init_done, portMAX_DELAY);
+    }
+
+    // add light sensor endpoint (later by periodic discovery when no sensor answers now)
+    GetBootTimeline()->begin(BootPhaseEndpoint);
+    if (m_sensor_present) {
+        attach_light_sensor();
     } else {
-        return false;
+        GetLogger(eLogType::Warning)->Log("No light sensor found, endpoint is added when attached");
     }
+    GetBootTimeline()->end(BootPhaseEndpoint);
 
     m_initialized = true;
     GetLogger(eLogType::Info)->Log("Initialized");
@@ -118,6 +195,118 @@ bool CSystem::initialize()
     return true;
 }
 
+bool CSystem::attach_light_sensor()
+{
+    bool result = false;
+    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    // same endpoint id whenever the sensor is (re)attached, then continue after the highest existing id
+    matter_set_min_endpoint_id(LIGHT_SENSOR_ENDPOINT_ID);
+    CLightSensor *sensor = new CLightSensor();
+    if (sensor && sensor->matter_init_endpoint()) {
+        m_device_list.push_back(sensor);
+        sensor->set_min_measured_value(1);
+        sensor->set_max_measured_value((uint16_t)(10000. * log10(140000.) + 1.));
+        result = true;
+    } else {
+        delete sensor;
+    }
+    matter_align_endpoint_id();
+    if (lock_status == esp_matter::lock::SUCCESS) {
+        esp_matter::lock::chip_stack_unlock();
+    }
+
+    m_sensor_attached = result;
+    if (result) {
+        GetLogger(eLogType::Info)->Log("Light sensor attached (endpoint id: %u)", LIGHT_SENSOR_ENDPOINT_ID);
+    } else {
+        GetLogger(eLogType::Error)->Log("Failed to add light sensor endpoint");
+    }
+    return result;
+}
+
+void CSystem::detach_light_sensor()
+{
+    m_sensor_attached = false;
+    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
+    // device list is only modified with chip stack locked (attribute callbacks run with it locked)
+    for (auto it = m_device_list.begin(); it != m_device_list.end(); ++it) {
+        if ((*it)->matter_get_endpoint_id() == LIGHT_SENSOR_ENDPOINT_ID) {
+            CDevice *dev = *it;
+            m_device_list.erase(it);
+            dev->matter_destroy_endpoint();
+            delete dev;
+            break;
+        }
+    }
+    matter_align_endpoint_id();
+    if (lock_status == esp_matter::lock::SUCCESS) {
+        esp_matter::lock::chip_stack_unlock();
+    }
+
+    // sensor is gone (no bus access): stop burst and drop retained state, next attach is a cold start
+    GetLightSensorDriver()->detach();
+    GetLogger(eLogType::Warning)->Log("Light sensor detached (endpoint id: %u)", LIGHT_SENSOR_ENDPOINT_ID);
+}
+
+void CSystem::update_sensor_presence()
+{
+    // called from the measurement task only (sole user of the sensor and the light sensor device)
+    bool present = GetBusDiscovery()->identify(LIGHT_SENSOR_PART);
+    if (present == m_sensor_attached) {
+        m_sensor_missing_count = 0;
+        return;
+    }
+
+    if (present) {
+        GetLogger(eLogType::Info)->Log("Light sensor found");
+        GetI2CMaster()->reset_breakers();
+        if (GetLightSensorDriver()->initialize(m_i2c_master)) {
+            apply_sensor_settings();
+            attach_light_sensor();
+        }
+    } else if (++m_sensor_missing_count >= DISCOVERY_MISSING_COUNT) {
+        m_sensor_missing_count = 0;
+        detach_light_sensor();
+    }
+}
+
+void CSystem::task_sensor_init_function(void *param)
+{
+    CSystem *obj = static_cast<CSystem *>(param);
+
+    GetBootTimeline()->begin(BootPhaseSensorInit);
+    obj->m_i2c_master = GetI2CMaster();
+    obj->m_i2c_master->initialize(I2C_PORT_NUM, GPIO_PIN_I2C_SCL, GPIO_PIN_I2C_SDA, I2C_MASTER_FREQ);
+    GetBusDiscovery()->initialize(obj->m_i2c_master);
+    GetLuxCalibration()->load();
+    bool result = GetBusDiscovery()->identify(LIGHT_SENSOR_PART) && GetLightSensorDriver()->initialize(obj->m_i2c_master);
+    if (result) {
+        obj->apply_sensor_settings();
+    }
+    obj->m_sensor_present = result;
+    GetBootTimeline()->end(BootPhaseSensorInit);
+
+    if (result) {
+        GetBootTimeline()->begin(BootPhaseFirstSample);
+        float retained_lux = 0.f;
+        if (GetVeml7700Ctrl()->get_retained_lux(&retained_lux)) {
+            // warm start: last lux before the reset is reported at once (no integration wait),
+            // only the lux value is used (published, not measured), the measurement task takes a real sample right after it
+            memset(&obj->m_boot_sample, 0, sizeof(obj->m_boot_sample));
+            obj->m_boot_sample.lux = retained_lux;
+            obj->m_boot_sample_retained = true;
+            obj->m_boot_sample_valid = true;
+            GetLogger(eLogType::Info)->Log("First report from retained state: %g lux", retained_lux);
+        } else {
+            obj->m_boot_sample_valid = GetLightSensorDriver()->read_measurement(&obj->m_boot_sample);
+        }
+        GetBootTimeline()->end(BootPhaseFirstSample);
+    }
+
+    xSemaphoreGive(obj->m_sensor_init_done);
+    vTaskDelete(nullptr);
+}
+
 void CSystem::release()
 {
     deinit_default_button();
@@ -133,21 +322,24 @@ void CSystem::callback_default_button(void *arg, void *data)
     switch (event) {
     case BUTTON_PRESS_DOWN: // 0
         break;
+    // runs in esp_timer task context: slow work is deferred to the worker task
     case BUTTON_PRESS_UP:   // 1
         if (m_default_btn_pressed_long) {
+            // called directly (never dropped / delayed behind a full job queue):
+            // esp_matter::factory_reset only schedules the reset on the CHIP task and returns
             _instance->factory_reset();
         }
         m_default_btn_pressed_long = false;
         break;
     case BUTTON_SINGLE_CLICK:   // 4
-        _instance->print_system_info();
+        _instance->post_job([](void *arg) { GetSystem()->print_system_info(); });
         break;
     case BUTTON_DOUBLE_CLICK:   // 5
-        _instance->print_matter_endpoints_info();
+        _instance->post_job([](void *arg) { GetSystem()->print_matter_endpoints_info(); });
         break;
     case BUTTON_LONG_PRESS_START:   // 6
         m_default_btn_pressed_long = true;
-        GetLogger(eLogType::Info)->Log("ready to factory reset");
+        _instance->post_job([](void *arg) { GetLogger(eLogType::Info)->Log("ready to factory reset"); });
         break;
     case BUTTON_LONG_PRESS_HOLD:    // 7
         m_default_btn_pressed_long = true;
@@ -307,11 +499,9 @@ void CSystem::print_matter_endpoints_info()
     esp_matter::endpoint_t *endpoint = esp_matter::endpoint::get_first(m_root_node);
     while (endpoint != nullptr) {
         endpoint_id = esp_matter::endpoint::get_id(endpoint);
-        cJSON *json = dump_matter_endpoint_info(endpoint_id);
-        char *string = cJSON_PrintUnformatted(json);
-        printf(string);
-        cJSON_Delete(json);
-        free(string);
+        CJsonWriter writer(json_sink_stdout, nullptr);
+        dump_matter_endpoint_info(endpoint_id, &writer);
+        writer.flush();
         printf("\n");
         endpoint = esp_matter::endpoint::get_next(endpoint);
     }
@@ -413,32 +603,483 @@ esp_err_t CSystem::matter_attribute_update_callback(esp_matter::attribute::callb
     return ESP_OK;
 }
 
+bool CSystem::matter_create_clus_metrics()
+{
+    esp_matter::endpoint_t *endpoint = esp_matter::endpoint::get(m_root_node, 0);
+    if (!endpoint)
+        return false;
+    esp_matter::cluster_t *cluster = esp_matter::cluster::create(endpoint, CLUSTER_ID_RUNTIME_METRICS, esp_matter::CLUSTER_FLAG_SERVER);
+    if (!cluster) {
+        GetLogger(eLogType::Error)->Log("Failed to create Runtime Metrics cluster");
+        return false;
+    }
+    esp_matter::cluster::global::attribute::create_cluster_revision(cluster, 1);
+    esp_matter::cluster::global::attribute::create_feature_map(cluster, 0);
+
+    for (uint32_t i = 0; i < MetricCounterCount; i++) {
+        esp_matter::attribute::create(cluster, ATTR_ID_METRICS_COUNTER_BASE + i, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+    }
+    for (uint32_t i = 0; i < MetricGaugeCount; i++) {
+        esp_matter::attribute::create(cluster, ATTR_ID_METRICS_GAUGE_BASE + i, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+    }
+    for (uint32_t i = 0; i < MetricHistogramCount; i++) {
+        uint32_t base = ATTR_ID_METRICS_HISTOGRAM_BASE + i * ATTR_ID_METRICS_HISTOGRAM_STRIDE;
+        for (uint32_t j = 0; j < METRIC_HISTOGRAM_BUCKET_COUNT; j++) {
+            esp_matter::attribute::create(cluster, base + ATTR_ID_METRICS_HISTOGRAM_BUCKET + j, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+        }
+        esp_matter::attribute::create(cluster, base + ATTR_ID_METRICS_HISTOGRAM_COUNT, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_METRICS_HISTOGRAM_SUM, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint64(0));
+        esp_matter::attribute::create(cluster, base + ATTR_ID_METRICS_HISTOGRAM_MAX, esp_matter::ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+    }
+
+    esp_matter::command::create(cluster, CMD_ID_METRICS_RESET, esp_matter::COMMAND_FLAG_ACCEPTED, matter_metrics_reset_command_callback);
+
+    return true;
+}
+
+void CSystem::matter_update_clus_metrics_attr(uint32_t attribute_id, esp_matter_attr_val_t value)
+{
+    esp_matter::endpoint_t *endpoint = esp_matter::endpoint::get(m_root_node, 0);
+    esp_matter::cluster_t *cluster = esp_matter::cluster::get(endpoint, CLUSTER_ID_RUNTIME_METRICS);
+    esp_matter::attribute_t *attribute = esp_matter::attribute::get(cluster, attribute_id);
+    if (!attribute)
+        return;
+
+    // report only changed values (not counted as attribute report metric)
+    esp_matter_attr_val_t current_value = esp_matter_invalid(nullptr);
+    if (esp_matter::attribute::get_val(attribute, &current_value) == ESP_OK && current_value.type == value.type) {
+        if (value.type == ESP_MATTER_VAL_TYPE_UINT32 && current_value.val.u32 == value.val.u32)
+            return;
+        if (value.type == ESP_MATTER_VAL_TYPE_UINT64 && current_value.val.u64 == value.val.u64)
+            return;
+    }
+    esp_matter::attribute::update(0, CLUSTER_ID_RUNTIME_METRICS, attribute_id, &value);
+}
+
+void CSystem::matter_update_clus_metrics_attr_all()
+{
+    if (!m_root_node)
+        return;
+
+    CMetrics *metrics = GetMetrics();
+    for (uint32_t i = 0; i < MetricCounterCount; i++) {
+        matter_update_clus_metrics_attr(ATTR_ID_METRICS_COUNTER_BASE + i, esp_matter_uint32(metrics->get_counter((eMetricCounter)i)));
+    }
+    for (uint32_t i = 0; i < MetricGaugeCount; i++) {
+        matter_update_clus_metrics_attr(ATTR_ID_METRICS_GAUGE_BASE + i, esp_matter_uint32(metrics->get_gauge((eMetricGauge)i)));
+    }
+    metric_histogram_t histogram;
+    for (uint32_t i = 0; i < MetricHistogramCount; i++) {
+        uint32_t base = ATTR_ID_METRICS_HISTOGRAM_BASE + i * ATTR_ID_METRICS_HISTOGRAM_STRIDE;
+        metrics->get_histogram((eMetricHistogram)i, &histogram);
+        for (uint32_t j = 0; j < METRIC_HISTOGRAM_BUCKET_COUNT; j++) {
+            matter_update_clus_metrics_attr(base + ATTR_ID_METRICS_HISTOGRAM_BUCKET + j, esp_matter_uint32(histogram.buckets[j]));
+        }
+        matter_update_clus_metrics_attr(base + ATTR_ID_METRICS_HISTOGRAM_COUNT, esp_matter_uint32(histogram.count));
+        matter_update_clus_metrics_attr(base + ATTR_ID_METRICS_HISTOGRAM_SUM, esp_matter_uint64(histogram.sum));
+        matter_update_clus_metrics_attr(base + ATTR_ID_METRICS_HISTOGRAM_MAX, esp_matter_uint32(histogram.max));
+    }
+}
+
+void CSystem::update_metrics_gauges()
+{
+    GetMetrics()->set_gauge(MetricHeapMinFree, esp_get_minimum_free_heap_size());
+    GetMetrics()->set_gauge(MetricHeapFree, esp_get_free_heap_size());
+
+    // stack high water mark (unit: byte on esp-idf) of application and matter tasks
+    const char *task_names[] = {"TASK_TIMER", "TASK_WORKER", "TASK_SETTINGS", "CHIP"};
+    uint32_t stack_min_free = UINT32_MAX;
+    for (auto & name : task_names) {
+        TaskHandle_t handle = xTaskGetHandle(name);
+        if (handle) {
+            uint32_t free_size = uxTaskGetStackHighWaterMark(handle);
+            if (free_size < stack_min_free)
+                stack_min_free = free_size;
+        }
+    }
+    if (stack_min_free != UINT32_MAX) {
+        GetMetrics()->set_gauge(MetricTaskStackMinFree, stack_min_free);
+    }
+}
+
+esp_err_t CSystem::matter_metrics_reset_command_callback(const chip::app::ConcreteCommandPath &command_path, chip::TLV::TLVReader &tlv_data, void *opaque_ptr)
+{
+    GetLogger(eLogType::Info)->Log("Runtime metrics reset by command");
+    GetMetrics()->reset();
+    GetSystem()->matter_update_clus_metrics_attr_all();
+    
+    return ESP_OK;
+}
+
+bool CSystem::start_flicker_capture(float last_lux)
+{
+    // highest gain which does not saturate at 25ms integration time (resolution: lux/count)
+    const uint8_t gain_word_array[] = {VEML7700_GAIN_2, VEML7700_GAIN_1, VEML7700_GAIN_1_4, VEML7700_GAIN_1_8};
+    const float resolution_array[] = {0.1152f, 0.2304f, 0.9216f, 1.8432f};
+    int gain_idx = 0;
+    while (gain_idx < 3 && last_lux * 1.5f / resolution_array[gain_idx] > 60000.f) {
+        gain_idx++;
+    }
+
+    // 120 Hz is 3 periods of 25ms (integration null at every VEML7700 integration time), reported as unsupported
+    m_flicker_integ_time_sec = 0.025f;
+    return GetVeml7700Ctrl()->start_burst(gain_word_array[gain_idx], VEML7700_IT_25MS, FLICKER_MAX_SAMPLES, FLICKER_BURST_PERIOD_US);
+}
+
+void CSystem::finish_flicker_capture()
+{
+    veml7700_burst_sample_t block[16];
+    size_t count = 0;
+    size_t read_count;
+    bool clipped = false;
+    while (count < FLICKER_MAX_SAMPLES) {
+        read_count = GetVeml7700Ctrl()->read_burst_block(block, MIN(16, FLICKER_MAX_SAMPLES - count));
+        if (read_count == 0)
+            break;
+        for (size_t i = 0; i < read_count; i++) {
+            clipped |= block[i].clipped;
+            m_flicker_samples[count++] = block[i].raw;
+        }
+    }
+    if (clipped) {
+        // modulation of a clipped waveform is meaningless, retry at the next analysis period
+        GetLogger(eLogType::Warning)->Log("Flicker capture clipped, result discarded");
+        return;
+    }
+
+    CFlickerAnalyzer analyzer;
+    flicker_result_t result;
+    if (analyzer.analyze(m_flicker_samples, count, GetVeml7700Ctrl()->get_burst_sample_rate(), m_flicker_integ_time_sec, &result)) {
+        CDevice *dev = find_device_by_endpoint_id(LIGHT_SENSOR_ENDPOINT_ID);
+        if (dev) {
+            dev->update_flicker_result(&result);
+        }
+    }
+}
+
 void CSystem::task_timer_function(void *param)
 {
     CSystem *obj = static_cast<CSystem *>(param);
     int64_t current_tick_us;
-    int64_t last_tick_us = 0;
+    int64_t next_sample_us = 0;     // scheduled start of the next measurement (0: now)
+    bool schedule_reset = true;     // schedule restarted (attach, period settings): no jitter reference
+    uint32_t schedule_period_ms = 0;
+    uint32_t schedule_min_period_ms = 0;
+    uint32_t schedule_max_period_ms = 0;
+    uint8_t schedule_adaptive = 0;
+    int64_t period_us;
+    int64_t last_stat_tick_us = 0;
+    int64_t last_history_tick_us = 0;
+    int64_t last_flicker_tick_us = 0;
+    int64_t last_discovery_tick_us = 0;
+    bool flicker_capturing = false;
+    bool measured;
     CDevice * dev;
     float illum_lux = 0.f;
+    float filtered_lux = -1.f;
+    float reported_lux = -1.f;
+    light_sample_t sample;
+    report_sample_t report;
+    sensor_settings_t settings;
+    sampling_settings_t sampling;
+    CAdaptiveSampler sampler;
+    statistics_result_t stat_results[STAT_WINDOW_COUNT];
 
     GetLogger(eLogType::Info)->Log("Realtime task (timer) started");
     while (obj->m_keepalive) {
+        // a burst (flicker capture or console) owns gain and integration time of the sensor
+        bool burst_running = GetVeml7700Ctrl()->is_burst_running();
         if (obj->m_initialized) {
             current_tick_us = esp_timer_get_time();
-            if (current_tick_us - last_tick_us >= MEASURE_PERIOD_US) {
-                if (GetVeml7700Ctrl()->read_measurement(&illum_lux)) {
-                    dev = obj->find_device_by_endpoint_id(1);
-                    if (dev) {
-                        dev->update_measured_value_illuminance((uint16_t)illum_lux);
+            GetSettings()->get(&settings);
+            GetSettings()->get_sampling(&sampling);
+            if (settings.period_ms != schedule_period_ms || sampling.adaptive != schedule_adaptive
+                || sampling.min_period_ms != schedule_min_period_ms || sampling.max_period_ms != schedule_max_period_ms) {
+                // period settings changed: next sample now instead of at the end of the old period
+                schedule_period_ms = settings.period_ms;
+                schedule_adaptive = sampling.adaptive;
+                schedule_min_period_ms = sampling.min_period_ms;
+                schedule_max_period_ms = sampling.max_period_ms;
+                next_sample_us = 0;
+                schedule_reset = true;
+            }
+            // no presence probing while a burst runs (a busy sensor must not count as missing and detach mid-burst)
+            if (current_tick_us - last_discovery_tick_us >= DISCOVERY_PERIOD_US && !burst_running) {
+                TRACE_SCOPE("task_timer_discovery");
+                bool attached = obj->m_sensor_attached;
+                obj->update_sensor_presence();
+                if (obj->m_sensor_attached != attached) {
+                    // new endpoint (or none): restart filter and report immediately
+                    filtered_lux = -1.f;
+                    reported_lux = -1.f;
+                    illum_lux = 0.f;
+                    sampler.reset();
+                    next_sample_us = 0;
+                    schedule_reset = true;
+                }
+                last_discovery_tick_us = current_tick_us;
+            }
+
+            // nothing to measure until discovery finds the sensor (again)
+            if (obj->m_sensor_attached && current_tick_us >= next_sample_us) {
+                TRACE_SCOPE("task_timer_measure");
+#if CONFIG_APP_JITTER_MONITOR
+                // start delay against a running schedule only (a reset schedule is due at once)
+                if (!schedule_reset) {
+                    GetMetrics()->record(MetricSampleJitter, (uint32_t)(current_tick_us - next_sample_us));
+                }
+#endif
+                schedule_reset = false;
+                // adaptive period is decided by the new sample (kept when the measurement fails)
+                if (sampling.adaptive && sampler.get_period_ms() > 0) {
+                    period_us = (int64_t)sampler.get_period_ms() * 1000;
+                } else {
+                    period_us = (int64_t)settings.period_ms * 1000;
+                }
+                bool retained = false;
+                if (obj->m_boot_sample_valid) {
+                    // taken by sensor init task while matter was starting (or retained across a warm restart)
+                    sample = obj->m_boot_sample;
+                    retained = obj->m_boot_sample_retained;
+                    obj->m_boot_sample_valid = false;
+                    obj->m_boot_sample_retained = false;
+                    measured = true;
+                } else if (burst_running) {
+                    // sample skipped (flicker capture is a scheduled pause, a console burst is not)
+                    measured = false;
+                    if (!flicker_capturing) {
+                        GetMetrics()->increment(MetricSampleFailed);
+                    }
+                } else {
+                    measured = GetLightSensorDriver()->read_measurement(&sample);
+                }
+                if (measured && retained) {
+                    // lux before the warm restart: published as is, no measurement of this boot
+                    // (statistics, history, sampler and filter start with the real sample, light source unknown)
+                    report.timestamp_us = current_tick_us;
+                    report.lux = sample.lux;
+                    report.report_lux = true;
+                    report.light_source = false;
+                    reported_lux = sample.lux;
+                    obj->publish_sample(&report);
+                    GetLogger(eLogType::Info)->Log("Retained illumination published: %g lux", sample.lux);
+                } else if (measured) {
+                    illum_lux = sample.lux;
+                    // exponential moving average + deadband (statistics and history use raw value)
+                    if (filtered_lux < 0.f) {
+                        filtered_lux = illum_lux;
+                    } else {
+                        filtered_lux += settings.filter_alpha * (illum_lux - filtered_lux);
+                    }
+                    // change detection on the reported (filtered) value: sensor noise does not shorten the period
+                    if (sampling.adaptive) {
+                        period_us = (int64_t)sampler.update(filtered_lux, sample.conversion_ms, &sampling) * 1000;
+                    }
+                    // a gap up to twice the longest sample period is held at the previous value
+                    GetLuxStatistics()->set_hold_limit(2000LL * (sampling.adaptive ? sampling.max_period_ms : settings.period_ms));
+                    GetLuxStatistics()->push(illum_lux, current_tick_us);
+                    if (current_tick_us - last_history_tick_us >= HISTORY_SAMPLE_PERIOD_US) {
+                        GetHistoryStore()->append(illum_lux);
+                        last_history_tick_us = current_tick_us;
+                    }
+                    // published from matter context (no chip stack lock wait here)
+                    report.timestamp_us = current_tick_us;
+                    report.lux = filtered_lux;
+                    report.report_lux = reported_lux < 0.f || fabsf(filtered_lux - reported_lux) * 100.f > settings.deadband_percent * reported_lux;
+                    report.light_source = true;
+                    report.source_class = sample.source_class;
+                    report.color_temperature = sample.color_temperature;
+                    if (report.report_lux) {
+                        reported_lux = filtered_lux;
                     }
-                    GetLogger(eLogType::Info)->Log("Measured illumination from sensor: %g lux", illum_lux);
+                    obj->publish_sample(&report);
+                    if (sample.clipped) {
+                        GetLogger(eLogType::Warning)->Log("Measured illumination from sensor: %g lux (clipped)", illum_lux);
+                    } else {
+                        GetLogger(eLogType::Info)->Log("Measured illumination from sensor: %g lux", illum_lux);
+                    }
+                }
+                // fixed rate schedule (no drift), restarts from now when a whole period was missed
+                next_sample_us += period_us;
+                if (next_sample_us <= current_tick_us) {
+                    next_sample_us = current_tick_us + period_us;
+                }
+                if (retained) {
+                    // retained value was published, measure the current one now
+                    next_sample_us = 0;
+                    schedule_reset = true;
+                }
+                GetMetrics()->set_gauge(MetricSamplePeriod, (uint32_t)(period_us / 1000));
+            }
+
+            if (current_tick_us - last_stat_tick_us >= STAT_REPORT_PERIOD_US) {
+                TRACE_SCOPE("task_timer_report");
+                for (int i = 0; i < STAT_WINDOW_COUNT; i++) {
+                    GetLuxStatistics()->get_result(i, current_tick_us, &stat_results[i]);
                 }
-                last_tick_us = current_tick_us;
+                dev = obj->find_device_by_endpoint_id(LIGHT_SENSOR_ENDPOINT_ID);
+                if (dev) {
+                    dev->update_illuminance_statistics(stat_results, STAT_WINDOW_COUNT);
+                }
+                obj->update_metrics_gauges();
+                obj->matter_update_clus_metrics_attr_all();
+                last_stat_tick_us = current_tick_us;
+            }
+
+            if (flicker_capturing) {
+                if (!GetVeml7700Ctrl()->is_burst_running()) {
+                    TRACE_SCOPE("task_timer_flicker");
+                    obj->finish_flicker_capture();
+                    flicker_capturing = false;
+                }
+            } else if (obj->m_sensor_attached && !burst_running && illum_lux > 0.f && current_tick_us - last_flicker_tick_us >= FLICKER_ANALYSIS_PERIOD_US) {
+                flicker_capturing = obj->start_flicker_capture(illum_lux);
+                last_flicker_tick_us = current_tick_us;
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(50));
+        // sleep until the earliest deadline (sample, statistics report, discovery, flicker), rounded up to a tick,
+        // woken early by a settings change (wake_measurement_task)
+        TickType_t wait_ticks = pdMS_TO_TICKS(50);
+        if (obj->m_initialized) {
+            int64_t deadline_us = last_stat_tick_us + STAT_REPORT_PERIOD_US;
+            if (flicker_capturing || GetVeml7700Ctrl()->is_burst_running()) {
+                // end of the burst is polled (discovery and flicker analysis wait for it)
+                deadline_us = MIN(deadline_us, esp_timer_get_time() + FLICKER_POLL_PERIOD_US);
+            } else {
+                deadline_us = MIN(deadline_us, last_discovery_tick_us + DISCOVERY_PERIOD_US);
+                if (obj->m_sensor_attached && illum_lux > 0.f) {
+                    deadline_us = MIN(deadline_us, last_flicker_tick_us + FLICKER_ANALYSIS_PERIOD_US);
+                }
+            }
+            if (obj->m_sensor_attached) {
+                deadline_us = MIN(deadline_us, next_sample_us);
+            }
+            int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+            int64_t wait_us = deadline_us - esp_timer_get_time();
+            wait_ticks = (TickType_t)MAX((wait_us + tick_us - 1) / tick_us, (int64_t)1);
+        }
+        ulTaskNotifyTake(pdTRUE, wait_ticks);
     }
     GetLogger(eLogType::Info)->Log("Realtime task (timer) terminated");
     vTaskDelete(nullptr);
-}
\ No newline at end of file
+}
+
+void CSystem::publish_sample(const report_sample_t *sample)
+{
+    if (!m_sample_queue.push(sample))
+        return;
+
+    // one pending drain at a time, cleared by the drain itself
+    if (!m_publish_scheduled.exchange(true)) {
+        if (chip::DeviceLayer::PlatformMgr().ScheduleWork(matter_publish_samples_work, reinterpret_cast<intptr_t>(this)) != CHIP_NO_ERROR) {
+            m_publish_scheduled = false;
+            GetLogger(eLogType::Warning)->Log("Failed to schedule sample publishing");
+        }
+    }
+}
+
+void CSystem::matter_publish_samples_work(intptr_t arg)
+{
+    // matter context (chip stack locked): sole consumer of the sample queue
+    CSystem *obj = reinterpret_cast<CSystem *>(arg);
+    obj->m_publish_scheduled = false;
+
+    report_sample_t sample;
+    report_sample_t last_sample;
+    bool has_sample = false;
+    bool report_lux = false;
+    float lux = 0.f;
+    uint8_t source_class = 0;
+    uint16_t color_temperature = 0;
+    bool light_source = false;
+    while (obj->m_sample_queue.pop(&sample)) {
+        // only the latest value of a backlog is published
+        if (sample.report_lux) {
+            report_lux = true;
+            lux = sample.lux;
+        }
+        if (sample.light_source) {
+            light_source = true;
+            source_class = sample.source_class;
+            color_temperature = sample.color_temperature;
+        }
+        last_sample = sample;
+        has_sample = true;
+    }
+    if (!has_sample)
+        return;
+    TRACE_INSTANT("matter_publish", (uint32_t)(esp_timer_get_time() - last_sample.timestamp_us));
+
+    CDevice *dev = obj->find_device_by_endpoint_id(LIGHT_SENSOR_ENDPOINT_ID);
+    if (!dev)
+        return;
+    if (report_lux) {
+        dev->update_measured_value_illuminance((uint16_t)lux);
+        if (!obj->m_first_reported) {
+            obj->m_first_reported = true;
+            GetBootTimeline()->end(BootPhaseFirstReport);
+            GetMetrics()->set_gauge(MetricBootTimeToFirstReport, GetBootTimeline()->get_elapsed_ms(BootPhaseFirstReport));
+            obj->post_job([](void *arg) { GetBootTimeline()->print_info(); });
+        }
+    }
+    if (light_source) {
+        dev->update_light_source(source_class, color_temperature);
+    }
+}
+
+void CSystem::wake_measurement_task()
+{
+    if (m_task_timer_handle) {
+        xTaskNotifyGive(m_task_timer_handle);
+    }
+}
+
+bool CSystem::apply_sensor_settings()
+{
+    sensor_settings_t settings;
+    GetSettings()->get(&settings);
+
+    bool result = GetLightSensorDriver()->set_ranging_policy((eRangingPolicy)settings.ranging_policy, settings.fixed_gain, settings.fixed_integ_time);
+    if (settings.power_saving_mode > 0) {
+        result &= GetLightSensorDriver()->set_power_saving(true, settings.power_saving_mode - 1);
+    } else {
+        result &= GetLightSensorDriver()->set_power_saving(false);
+    }
+    if (!result) {
+        GetLogger(eLogType::Error)->Log("Failed to apply sensor settings");
+    }
+
+    return result;
+}
+
+bool CSystem::post_job(system_job_func_t func, void *arg/*=nullptr*/)
+{
+    if (!m_job_queue || !func)
+        return false;
+
+    system_job_t job = {func, arg};
+    // no wait: may be called from timer / callback context
+    if (xQueueSend(m_job_queue, &job, 0) != pdTRUE) {
+        GetLogger(eLogType::Warning)->Log("Job queue full, job dropped");
+        return false;
+    }
+
+    return true;
+}
+
+void CSystem::task_worker_function(void *param)
+{
+    CSystem *obj = static_cast<CSystem *>(param);
+    system_job_t job;
+
+    GetLogger(eLogType::Info)->Log("Worker task started");
+    while (obj->m_keepalive) {
+        if (xQueueReceive(obj->m_job_queue, &job, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            TRACE_SCOPE("task_worker_job");
+            job.func(job.arg);
+        }
+    }
+    GetLogger(eLogType::Info)->Log("Worker task terminated");
+    vTaskDelete(nullptr);
+}
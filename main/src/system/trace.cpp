@@ -0,0 +1,83 @@
+#include "trace.h"
+#include "logger.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include <stdio.h>
+#include <string.h>
+
+CTrace* CTrace::_instance = nullptr;
+
+CTrace::CTrace()
+{
+    m_enabled = false;
+    m_write_index = 0;
+    memset(m_events, 0, sizeof(m_events));
+}
+
+CTrace::~CTrace()
+{
+}
+
+CTrace* CTrace::Instance()
+{
+    if (!_instance) {
+        _instance = new CTrace();
+    }
+
+    return _instance;
+}
+
+void CTrace::start()
+{
+    m_enabled.store(true, std::memory_order_relaxed);
+    GetLogger(eLogType::Info)->Log("Trace started (buffer: %d events)", TRACE_BUFFER_SIZE);
+}
+
+void CTrace::stop()
+{
+    m_enabled.store(false, std::memory_order_relaxed);
+    GetLogger(eLogType::Info)->Log("Trace stopped");
+}
+
+void CTrace::clear()
+{
+    bool enabled = m_enabled.exchange(false);
+    m_write_index.store(0, std::memory_order_relaxed);
+    m_enabled.store(enabled);
+}
+
+void CTrace::record(char phase, const char *name, uint32_t arg/*=0*/)
+{
+    if (!m_enabled.load(std::memory_order_relaxed))
+        return;
+
+    // slot is reserved atomically, so concurrent writers never share an entry
+    uint32_t index = m_write_index.fetch_add(1, std::memory_order_relaxed);
+    trace_event_t *event = &m_events[index % TRACE_BUFFER_SIZE];
+    event->timestamp_us = (uint32_t)esp_timer_get_time();
+    event->name = name;
+    event->arg = arg;
+    event->phase = phase;
+    event->core = (uint8_t)esp_cpu_get_core_id();
+    strncpy(event->task, pcTaskGetName(nullptr), TRACE_TASK_NAME_LEN - 1);
+    event->task[TRACE_TASK_NAME_LEN - 1] = '\0';
+}
+
+void CTrace::dump()
+{
+    // recording is paused while printing (uart output is slow)
+    bool enabled = m_enabled.exchange(false);
+    uint32_t write_index = m_write_index.load();
+    uint32_t count = write_index < TRACE_BUFFER_SIZE ? write_index : TRACE_BUFFER_SIZE;
+
+    printf("# trace begin (events: %u, dropped: %u)\n", count, write_index - count);
+    for (uint32_t i = write_index - count; i != write_index; i++) {
+        const trace_event_t *event = &m_events[i % TRACE_BUFFER_SIZE];
+        printf("%u,%c,%u,%s,%s,%u\n", event->timestamp_us, event->phase, event->core, event->task, event->name, event->arg);
+    }
+    printf("# trace end\n");
+
+    m_enabled.store(enabled);
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+# fit_calibration.py
+# purpose: fit per-unit lux calibration coefficients from reference meter data
+# input: csv file with columns 'sensor_lux' (uncalibrated device reading) and 'reference_lux'
+# output: console commands for the device (matter calib ...)
+import argparse
+import csv
+import sys
+
+TABLE_SIZE = 8  # CALIB_TABLE_SIZE (calibration.h)
+
+
+def load_csv(path):
+    points = []
+    with open(path, newline='') as f:
+        for row in csv.DictReader(f):
+            points.append((float(row['sensor_lux']), float(row['reference_lux'])))
+    points.sort()
+    return points
+
+
+def fit_linear(points):
+    n = len(points)
+    sx = sum(p[0] for p in points)
+    sy = sum(p[1] for p in points)
+    sxx = sum(p[0] * p[0] for p in points)
+    sxy = sum(p[0] * p[1] for p in points)
+    den = n * sxx - sx * sx
+    if den == 0:
+        raise ValueError('degenerate input data')
+    gain = (n * sxy - sx * sy) / den
+    offset = (sy - gain * sx) / n
+    return gain, offset
+
+
+def fit_table(points, gain, offset, glass, size):
+    # piecewise linear residual correction at quantile breakpoints (mean of each bucket)
+    mapped = [((x * gain / glass) + offset, y) for x, y in points]
+    if len(mapped) < size * 2:
+        return []
+    table = []
+    bucket = len(mapped) / size
+    for i in range(size):
+        chunk = mapped[int(i * bucket):int((i + 1) * bucket)]
+        xin = sum(p[0] for p in chunk) / len(chunk)
+        xout = sum(p[1] for p in chunk) / len(chunk)
+        if table and xin <= table[-1][0]:
+            continue
+        table.append((xin, xout))
+    return table
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Fit VEML7700 calibration from reference meter csv')
+    parser.add_argument('csv', help='csv file (sensor_lux, reference_lux)')
+    parser.add_argument('--glass', type=float, default=1.0, help='known cover glass transmittance (0 ~ 1]')
+    parser.add_argument('--table', action='store_true', help='fit piecewise linear correction table')
+    args = parser.parse_args()
+
+    points = load_csv(args.csv)
+    if len(points) < 2:
+        print('not enough data points', file=sys.stderr)
+        return 1
+
+    gain, offset = fit_linear(points)
+    gain *= args.glass  # gain is applied together with 1 / transmittance on device
+    residual = max(abs(gain / args.glass * x + offset - y) for x, y in points)
+    print('# points: %d, max residual (linear): %.3f lux' % (len(points), residual))
+    print('matter calib set %.6g %.6g %.6g' % (gain, offset, args.glass))
+    if args.table:
+        table = fit_table(points, gain, offset, args.glass, TABLE_SIZE)
+        if table:
+            print('matter calib table ' + ' '.join('%.6g:%.6g' % p for p in table))
+    print('matter calib save')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
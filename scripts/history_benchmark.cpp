@@ -0,0 +1,131 @@
+// history_benchmark.cpp
+// purpose: compression ratio and encode / decode throughput of the history page codec
+//          on synthetic lux series (raw record: 4 byte timestamp + 4 byte float)
+// build (host):
+//   $ g++ -O2 -std=c++17 -I main/include/system scripts/history_benchmark.cpp main/src/system/historycodec.cpp -o /tmp/history_benchmark
+// usage: /tmp/history_benchmark [samples] [iterations]
+#include "historycodec.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+typedef enum
+{
+    SeriesConstant = 0,     // dark room / stable light (deadband filtered sensor output)
+    SeriesStep,             // lamp switched every 10 minutes
+    SeriesDaylight,         // slow daylight curve, sensor quantization (0.0576 lux/count)
+    SeriesNoisy,            // daylight + cloud noise (full float mantissa)
+    SeriesCount
+} eSeries;
+
+static const char *series_name[SeriesCount] = {"constant", "step", "daylight", "noisy"};
+
+static void generate(eSeries series, std::vector<history_sample_t> &samples)
+{
+    srand(1);
+    uint32_t timestamp = 1700000000u;
+    for (size_t i = 0; i < samples.size(); i++) {
+        float value;
+        switch (series) {
+        case SeriesConstant:
+            value = 312.5f;
+            break;
+        case SeriesStep:
+            value = (i / 60) % 2 ? 450.f : 3.2f;
+            break;
+        case SeriesDaylight:
+            value = roundf((20000.f * fmaxf(sinf((float)i * 3.14159f / 8640.f), 0.f)) / 0.0576f) * 0.0576f;
+            break;
+        default:
+            value = 20000.f * fmaxf(sinf((float)i * 3.14159f / 8640.f), 0.f) * (0.8f + 0.4f * (float)rand() / RAND_MAX);
+            break;
+        }
+        samples[i].timestamp = timestamp;
+        samples[i].value = value;
+        samples[i].boot_count = 1;
+        samples[i].flags = HISTORY_FLAG_EPOCH;
+        // HISTORY_SAMPLE_PERIOD_US (10s) with occasional 1s scheduling jitter
+        timestamp += (rand() % 16 == 0) ? 11 : 10;
+    }
+}
+
+static size_t encode_all(const std::vector<history_sample_t> &samples, std::vector<uint8_t> &pages)
+{
+    CHistoryPageEncoder encoder;
+    size_t page_count = 0;
+    uint32_t sequence = 0;
+    encoder.begin(sequence, 1, HISTORY_FLAG_EPOCH);
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (!encoder.append(&samples[i])) {
+            encoder.finish();
+            memcpy(&pages[page_count++ * HISTORY_PAGE_SIZE], encoder.get_data(), HISTORY_PAGE_SIZE);
+            encoder.begin(++sequence, 1, HISTORY_FLAG_EPOCH);
+            encoder.append(&samples[i]);
+        }
+    }
+    encoder.finish();
+    memcpy(&pages[page_count++ * HISTORY_PAGE_SIZE], encoder.get_data(), HISTORY_PAGE_SIZE);
+    return page_count;
+}
+
+static size_t decode_all(const std::vector<uint8_t> &pages, size_t page_count, double *checksum)
+{
+    CHistoryPageDecoder decoder;
+    history_sample_t sample;
+    size_t count = 0;
+    for (size_t i = 0; i < page_count; i++) {
+        if (!decoder.begin(&pages[i * HISTORY_PAGE_SIZE], HISTORY_PAGE_SIZE))
+            continue;
+        while (decoder.next(&sample)) {
+            *checksum += sample.value;
+            count++;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t sample_count = argc > 1 ? (size_t)atoi(argv[1]) : 8640;    // 1 day at 10s
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+    if (sample_count == 0 || iterations <= 0) {
+        printf("usage: %s [samples] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<history_sample_t> samples(sample_count);
+    std::vector<uint8_t> pages(sample_count * HISTORY_PAGE_SIZE);
+    printf("%zu samples, %d iterations, %d byte pages\n", sample_count, iterations, HISTORY_PAGE_SIZE);
+    printf("%-10s %8s %10s %8s %12s %12s\n", "series", "pages", "byte/smp", "ratio", "enc Msmp/s", "dec Msmp/s");
+    for (int s = 0; s < SeriesCount; s++) {
+        generate((eSeries)s, samples);
+        size_t page_count = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            page_count = encode_all(samples, pages);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double checksum = 0.;
+        size_t decoded = 0;
+        for (int i = 0; i < iterations; i++) {
+            decoded = decode_all(pages, page_count, &checksum);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        if (decoded != sample_count) {
+            printf("%s: decoded %zu of %zu samples\n", series_name[s], decoded, sample_count);
+            return 1;
+        }
+
+        double enc_sec = std::chrono::duration<double>(t1 - t0).count();
+        double dec_sec = std::chrono::duration<double>(t2 - t1).count();
+        double bytes_per_sample = (double)(page_count * HISTORY_PAGE_SIZE) / (double)sample_count;
+        printf("%-10s %8zu %10.2f %7.2fx %12.1f %12.1f\n", series_name[s], page_count, bytes_per_sample,
+            8. / bytes_per_sample,
+            (double)sample_count * iterations / enc_sec / 1e6,
+            (double)sample_count * iterations / dec_sec / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,217 @@
+// history_codec_test.cpp
+// purpose: host test of the history page codec (varint, crc, page round trip, corrupted / erased pages)
+// build (host):
+//   $ g++ -O2 -std=c++17 -I main/include/system scripts/history_codec_test.cpp main/src/system/historycodec.cpp -o /tmp/history_codec_test
+// usage: /tmp/history_codec_test (exit code 0: all passed)
+#include "historycodec.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void test_varint()
+{
+    const uint64_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 0xFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull};
+    for (uint64_t value : values) {
+        uint8_t buffer[10];
+        uint64_t decoded = 0;
+        size_t len = history_varint_encode(value, buffer);
+        CHECK(len >= 1 && len <= 10);
+        CHECK(history_varint_decode(buffer, len, &decoded) == len);
+        CHECK(decoded == value);
+        // truncated input is rejected
+        if (len > 1) {
+            CHECK(history_varint_decode(buffer, len - 1, &decoded) == 0);
+        }
+    }
+    uint8_t one_byte[1];
+    CHECK(history_varint_encode(127, one_byte) == 1);
+}
+
+static void test_crc()
+{
+    // CRC-32/ISO-HDLC check value
+    const char *check = "123456789";
+    CHECK(history_crc32(0, (const uint8_t *)check, strlen(check)) == 0xCBF43926);
+    // incremental == one shot
+    uint32_t crc = history_crc32(0, (const uint8_t *)check, 4);
+    CHECK(history_crc32(crc, (const uint8_t *)check + 4, 5) == 0xCBF43926);
+}
+
+// encodes samples into consecutive pages, decodes them back and compares bit exact
+static bool round_trip(const history_sample_t *samples, size_t count, uint16_t boot_count, uint8_t flags, size_t *page_count)
+{
+    CHistoryPageEncoder encoder;
+    CHistoryPageDecoder decoder;
+    uint8_t page[HISTORY_PAGE_SIZE];
+    size_t encoded = 0;
+    size_t decoded = 0;
+    uint32_t sequence = 0;
+    bool ok = true;
+    *page_count = 0;
+
+    while (encoded < count) {
+        encoder.begin(sequence, boot_count, flags);
+        while (encoded < count && encoder.append(&samples[encoded])) {
+            encoded++;
+        }
+        if (encoder.get_count() == 0)
+            return false;
+        encoder.finish();
+        memcpy(page, encoder.get_data(), HISTORY_PAGE_SIZE);
+        (*page_count)++;
+
+        if (!decoder.begin(page, sizeof(page)))
+            return false;
+        ok &= decoder.get_sequence() == sequence;
+        ok &= decoder.get_count() == encoder.get_count();
+        history_sample_t sample;
+        while (decoder.next(&sample)) {
+            uint32_t expected_bits, actual_bits;
+            memcpy(&expected_bits, &samples[decoded].value, sizeof(expected_bits));
+            memcpy(&actual_bits, &sample.value, sizeof(actual_bits));
+            ok &= sample.timestamp == samples[decoded].timestamp;
+            ok &= actual_bits == expected_bits;
+            ok &= sample.boot_count == boot_count;
+            ok &= sample.flags == flags;
+            decoded++;
+        }
+        sequence++;
+    }
+    return ok && decoded == count;
+}
+
+static void test_round_trip()
+{
+    const size_t count = 2000;
+    history_sample_t *samples = new history_sample_t[count];
+    size_t pages;
+
+    // regular 10s period, constant value
+    for (size_t i = 0; i < count; i++) {
+        samples[i].timestamp = 1700000000u + (uint32_t)i * 10;
+        samples[i].value = 321.5f;
+    }
+    CHECK(round_trip(samples, count, 7, HISTORY_FLAG_EPOCH, &pages));
+
+    // jittered period, slowly varying value
+    srand(1);
+    uint32_t timestamp = 5;
+    for (size_t i = 0; i < count; i++) {
+        timestamp += 9 + rand() % 3;
+        samples[i].timestamp = timestamp;
+        samples[i].value = 500.f + 400.f * sinf((float)i * 0.01f);
+    }
+    CHECK(round_trip(samples, count, 1, 0, &pages));
+
+    // random values and gaps (incl. zero delta and large jumps), special floats
+    for (size_t i = 0; i < count; i++) {
+        timestamp += (rand() % 4 == 0) ? 0 : (uint32_t)(rand() % 100000);
+        samples[i].timestamp = timestamp;
+        uint32_t bits = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        memcpy(&samples[i].value, &bits, sizeof(bits));
+    }
+    samples[10].value = 0.f;
+    samples[11].value = -0.f;
+    samples[12].value = INFINITY;
+    samples[13].value = 140000.f;
+    CHECK(round_trip(samples, count, 65535, 0, &pages));
+
+    // backward clock step (e.g. sync correction) and wrap around of uint32 timestamp
+    samples[0].timestamp = 0xFFFFFFF0u;
+    samples[1].timestamp = 0xFFFFFFFFu;
+    samples[2].timestamp = 0xFFFFFF00u;
+    samples[3].timestamp = 3;
+    CHECK(round_trip(samples, 4, 2, 0, &pages));
+    CHECK(pages == 1);
+
+    delete[] samples;
+}
+
+static void test_page_full()
+{
+    CHistoryPageEncoder encoder;
+    history_sample_t sample = {0, 0.f, 0, 0};
+    encoder.begin(0);
+    uint16_t count = 0;
+    uint32_t bits = 0x12345678;
+    while (true) {
+        sample.timestamp += 1000;
+        bits = bits * 1103515245u + 12345u;
+        memcpy(&sample.value, &bits, sizeof(bits));
+        if (!encoder.append(&sample))
+            break;
+        count++;
+    }
+    // rejected sample leaves the page unchanged
+    CHECK(encoder.get_count() == count);
+    CHECK(encoder.get_used_size() <= HISTORY_PAGE_SIZE);
+}
+
+static void test_invalid_pages()
+{
+    CHistoryPageEncoder encoder;
+    CHistoryPageDecoder decoder;
+    uint8_t page[HISTORY_PAGE_SIZE];
+
+    // erased flash
+    memset(page, 0xFF, sizeof(page));
+    CHECK(!decoder.begin(page, sizeof(page)));
+    // too small buffer
+    CHECK(!decoder.begin(page, sizeof(page) - 1));
+
+    // empty page is never valid
+    encoder.begin(3, 1, 0);
+    encoder.finish();
+    memcpy(page, encoder.get_data(), sizeof(page));
+    CHECK(!decoder.begin(page, sizeof(page)));
+
+    history_sample_t sample = {100, 1.f, 0, 0};
+    encoder.begin(4, 1, 0);
+    for (int i = 0; i < 10; i++) {
+        sample.timestamp += 10;
+        sample.value += 1.f;
+        encoder.append(&sample);
+    }
+    encoder.finish();
+    memcpy(page, encoder.get_data(), sizeof(page));
+    CHECK(decoder.begin(page, sizeof(page)));
+
+    // any flipped bit (header or records) is detected by crc
+    for (size_t offset = 0; offset < encoder.get_used_size(); offset++) {
+        if (offset >= offsetof(history_page_header_t, crc) && offset < sizeof(history_page_header_t))
+            continue;
+        memcpy(page, encoder.get_data(), sizeof(page));
+        page[offset] ^= 0x04;
+        CHECK(!decoder.begin(page, sizeof(page)));
+    }
+    // header of the previous page format ('HS') is ignored
+    memcpy(page, encoder.get_data(), sizeof(page));
+    page[0] = 0x53;
+    CHECK(!decoder.begin(page, sizeof(page)));
+}
+
+int main(int argc, char *argv[])
+{
+    test_varint();
+    test_crc();
+    test_round_trip();
+    test_page_full();
+    test_invalid_pages();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All history codec tests passed\n");
+    return 0;
+}
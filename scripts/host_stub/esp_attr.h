@@ -0,0 +1,4 @@
+// esp_attr.h (host stub)
+#pragma once
+
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,7 @@
+// esp_err.h (host stub)
+#pragma once
+
+typedef int esp_err_t;
+
+#define ESP_OK      0
+#define ESP_FAIL    -1
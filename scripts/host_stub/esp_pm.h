@@ -0,0 +1,5 @@
+// esp_pm.h (host stub)
+#pragma once
+#include "esp_err.h"
+
+typedef void* esp_pm_lock_handle_t;
@@ -0,0 +1,26 @@
+// freertos/FreeRTOS.h (host stub)
+// types and the subset of the FreeRTOS api used by the host tested sources, implemented in host_stub.cpp
+// (single threaded: delays advance the simulated clock of esp_timer_get_time)
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct { int owner; } portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    {0}
+#define portENTER_CRITICAL(mux)         (void)(mux)
+#define portEXIT_CRITICAL(mux)          (void)(mux)
+#define portMAX_DELAY                   0xFFFFFFFFu
+#define portTICK_PERIOD_MS              10
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define pdPASS                          1
+#define pdFAIL                          0
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define tskNO_AFFINITY                  0x7FFFFFFF
@@ -0,0 +1,7 @@
+// freertos/semphr.h (host stub)
+#pragma once
+#include "FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
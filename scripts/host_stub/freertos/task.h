@@ -0,0 +1,11 @@
+// freertos/task.h (host stub)
+#pragma once
+#include "FreeRTOS.h"
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *name, uint32_t stack_depth, void *param,
+    UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t handle);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t handle);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
@@ -0,0 +1,243 @@
+// host_stub.cpp
+// single threaded host implementation of the FreeRTOS / esp-idf api and of the application singletons
+// (logger, trace, power manager, lux calibration) that firmware sources call, for the host tests of scripts/
+#include "host_stub.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+#include "logger.h"
+#include "trace.h"
+#include "powermanager.h"
+#include "calibration.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static int64_t s_time_us = 0;
+static int s_reset_reason = ESP_RST_POWERON;
+static bool s_log_enabled = false;
+static int s_pm_lock_depth = 0;
+
+void host_advance_us(int64_t us)
+{
+    s_time_us += us;
+}
+
+void host_set_reset_reason(int reason)
+{
+    s_reset_reason = reason;
+}
+
+void host_set_log_enabled(bool enabled)
+{
+    s_log_enabled = enabled;
+}
+
+int host_get_pm_lock_depth()
+{
+    return s_pm_lock_depth;
+}
+
+/* FreeRTOS (no tasks: task creation fails, blocking calls return at once) */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *name, uint32_t stack_depth, void *param,
+    UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    return pdFAIL;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_time_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return nullptr;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    return 1;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    static int mutex;
+    return &mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return pdTRUE;
+}
+
+/* esp-idf */
+int64_t esp_timer_get_time()
+{
+    return s_time_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t handle, uint64_t period_us)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return (esp_reset_reason_t)s_reset_reason;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/* application singletons */
+CLogger* CLogger::_instance = nullptr;
+
+CLogger::CLogger()
+{
+    m_valid_funcinfo = false;
+    m_eLogType = eLogType::Info;
+    m_fileline = 0;
+}
+
+CLogger::~CLogger()
+{
+}
+
+CLogger* CLogger::Instance(eLogType logtype, const char* funcname, const char* filename, const unsigned long fileline)
+{
+    if (!_instance) {
+        _instance = new CLogger();
+    }
+    _instance->m_eLogType = logtype;
+    return _instance;
+}
+
+void CLogger::Log(const char* msg, ...)
+{
+    if (!s_log_enabled)
+        return;
+    va_list args;
+    va_start(args, msg);
+    vprintf(msg, args);
+    va_end(args);
+    printf("\n");
+}
+
+CTrace* CTrace::_instance = nullptr;
+
+CTrace::CTrace()
+{
+    m_enabled = false;
+    m_write_index = 0;
+}
+
+CTrace::~CTrace()
+{
+}
+
+CTrace* CTrace::Instance()
+{
+    if (!_instance) {
+        _instance = new CTrace();
+    }
+    return _instance;
+}
+
+void CTrace::record(char phase, const char *name, uint32_t arg/*=0*/)
+{
+}
+
+CPowerManager* CPowerManager::_instance = nullptr;
+
+CPowerManager::CPowerManager()
+{
+    m_initialized = false;
+}
+
+CPowerManager::~CPowerManager()
+{
+}
+
+CPowerManager* CPowerManager::Instance()
+{
+    if (!_instance) {
+        _instance = new CPowerManager();
+    }
+    return _instance;
+}
+
+void CPowerManager::acquire(ePmLockType type)
+{
+    s_pm_lock_depth++;
+}
+
+void CPowerManager::release(ePmLockType type)
+{
+    s_pm_lock_depth--;
+}
+
+// identity calibration (per unit calibration has its own settings store dependency)
+CLuxCalibration* CLuxCalibration::_instance = nullptr;
+
+CLuxCalibration::CLuxCalibration()
+{
+    m_revision = 0;
+}
+
+CLuxCalibration::~CLuxCalibration()
+{
+}
+
+CLuxCalibration* CLuxCalibration::Instance()
+{
+    if (!_instance) {
+        _instance = new CLuxCalibration();
+    }
+    return _instance;
+}
+
+float CLuxCalibration::apply(float lux_linear)
+{
+    return lux_linear;
+}
@@ -0,0 +1,13 @@
+// host_stub.h
+// controls of the host stubs (host_stub.cpp) used by the host tests of scripts/
+#pragma once
+#include <stdint.h>
+
+// simulated clock returned by esp_timer_get_time, advanced by vTaskDelay and host_advance_us
+void host_advance_us(int64_t us);
+// reset reason reported by esp_reset_reason (default: power on = cold start)
+void host_set_reset_reason(int reason);
+// logger output to stdout (default: off)
+void host_set_log_enabled(bool enabled);
+// power management locks currently held (acquire - release)
+int host_get_pm_lock_depth();
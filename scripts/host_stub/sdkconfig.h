@@ -0,0 +1,10 @@
+// sdkconfig.h (host stub)
+// minimal Kconfig values needed to build firmware sources in the host tests of scripts/
+#pragma once
+
+#define CONFIG_APP_MATTER_NAME_TABLE        1
+#define CONFIG_APP_TASK_PINNING             0
+#define CONFIG_APP_BUS_TASK_PRIORITY        5
+#define CONFIG_APP_SENSOR_TASK_PRIORITY     5
+#define CONFIG_APP_WORKER_TASK_PRIORITY     1
+#define CONFIG_APP_JITTER_MONITOR           1
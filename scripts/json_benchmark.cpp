@@ -0,0 +1,154 @@
+// json_benchmark.cpp
+// purpose: compare peak heap and time of cJSON tree building (previous endpoint dump path)
+//          against the streaming CJsonWriter, on a synthetic data model of the same shape
+// build (host):
+//   $ gcc -O2 -c $IDF_PATH/components/json/cJSON/cJSON.c -o /tmp/cJSON.o
+//   $ g++ -O2 -std=c++17 -I main/include/system -I $IDF_PATH/components/json/cJSON
+//         scripts/json_benchmark.cpp main/src/system/jsonwriter.cpp /tmp/cJSON.o -o /tmp/json_benchmark
+// usage: /tmp/json_benchmark [clusters per endpoint] [attributes per cluster] [iterations]
+#include "jsonwriter.h"
+#include "cJSON.h"
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t heap_current = 0;
+static size_t heap_peak = 0;
+
+static void *counting_malloc(size_t size)
+{
+    size_t *ptr = (size_t *)malloc(size + sizeof(size_t));
+    if (!ptr)
+        return nullptr;
+    *ptr = size;
+    heap_current += size;
+    if (heap_current > heap_peak)
+        heap_peak = heap_current;
+    return ptr + 1;
+}
+
+static void counting_free(void *ptr)
+{
+    if (!ptr)
+        return;
+    size_t *base = (size_t *)ptr - 1;
+    heap_current -= *base;
+    free(base);
+}
+
+void *operator new(size_t size) { return counting_malloc(size); }
+void *operator new[](size_t size) { return counting_malloc(size); }
+void operator delete(void *ptr) noexcept { counting_free(ptr); }
+void operator delete[](void *ptr) noexcept { counting_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { counting_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { counting_free(ptr); }
+
+static size_t output_bytes = 0;
+
+static void null_sink(const char *data, size_t len, void *ctx)
+{
+    output_bytes += len;
+}
+
+static void dump_cjson(int endpoint_id, int clusters, int attributes)
+{
+    char temp[64];
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "endpoint_id", endpoint_id);
+    cJSON *array_device_type = cJSON_CreateArray();
+    cJSON_AddItemToObject(root, "device_type", array_device_type);
+    cJSON *item = cJSON_CreateObject();
+    cJSON_AddItemToArray(array_device_type, item);
+    cJSON_AddStringToObject(item, "id", "0x0106");
+    cJSON_AddStringToObject(item, "name", "Light Sensor");
+    cJSON *array_cluster = cJSON_CreateArray();
+    cJSON_AddItemToObject(root, "clusters", array_cluster);
+    for (int c = 0; c < clusters; c++) {
+        item = cJSON_CreateObject();
+        cJSON_AddItemToArray(array_cluster, item);
+        snprintf(temp, sizeof(temp), "0x%08X", c);
+        cJSON_AddStringToObject(item, "id", temp);
+        cJSON_AddStringToObject(item, "name", "Illuminance Measurement");
+        cJSON *array_attribute = cJSON_CreateArray();
+        cJSON_AddItemToObject(item, "attributes", array_attribute);
+        for (int a = 0; a < attributes; a++) {
+            cJSON *item2 = cJSON_CreateObject();
+            cJSON_AddItemToArray(array_attribute, item2);
+            snprintf(temp, sizeof(temp), "0x%08X", a);
+            cJSON_AddStringToObject(item2, "id", temp);
+            cJSON_AddStringToObject(item2, "name", "MeasuredValue");
+            cJSON_AddItemToObject(item2, "value", cJSON_CreateNumber(a * 1.5));
+        }
+        cJSON *array_command = cJSON_CreateArray();
+        cJSON_AddItemToObject(item, "commands", array_command);
+    }
+    char *string = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    null_sink(string, strlen(string), nullptr);
+    cJSON_free(string);
+}
+
+static void dump_writer(int endpoint_id, int clusters, int attributes)
+{
+    CJsonWriter writer(null_sink, nullptr);
+    writer.begin_object();
+    writer.write_uint("endpoint_id", endpoint_id);
+    writer.begin_array("device_type");
+    writer.begin_object();
+    writer.write_hex("id", 0x0106, 4);
+    writer.write_string("name", "Light Sensor");
+    writer.end_object();
+    writer.end_array();
+    writer.begin_array("clusters");
+    for (int c = 0; c < clusters; c++) {
+        writer.begin_object();
+        writer.write_hex("id", c, 8);
+        writer.write_string("name", "Illuminance Measurement");
+        writer.begin_array("attributes");
+        for (int a = 0; a < attributes; a++) {
+            writer.begin_object();
+            writer.write_hex("id", a, 8);
+            writer.write_string("name", "MeasuredValue");
+            writer.write_float("value", a * 1.5);
+            writer.end_object();
+        }
+        writer.end_array();
+        writer.begin_array("commands");
+        writer.end_array();
+        writer.end_object();
+    }
+    writer.end_array();
+    writer.end_object();
+    writer.flush();
+}
+
+static void run(const char *name, void (*func)(int, int, int), int clusters, int attributes, int iterations)
+{
+    heap_current = 0;
+    heap_peak = 0;
+    output_bytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        func(1, clusters, attributes);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - begin).count() / iterations;
+    printf("%-8s peak heap: %7zu bytes, time: %8.1f us/dump, output: %zu bytes\n", name, heap_peak, us, output_bytes / iterations);
+}
+
+int main(int argc, char **argv)
+{
+    int clusters = argc > 1 ? atoi(argv[1]) : 16;
+    int attributes = argc > 2 ? atoi(argv[2]) : 12;
+    int iterations = argc > 3 ? atoi(argv[3]) : 1000;
+
+    cJSON_Hooks hooks = {counting_malloc, counting_free};
+    cJSON_InitHooks(&hooks);
+
+    printf("# clusters: %d, attributes per cluster: %d, iterations: %d\n", clusters, attributes, iterations);
+    run("cJSON", dump_cjson, clusters, attributes, iterations);
+    run("writer", dump_writer, clusters, attributes, iterations);
+    return 0;
+}
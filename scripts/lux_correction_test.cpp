@@ -0,0 +1,132 @@
+// lux_correction_test.cpp
+// purpose: host test of the constexpr non-linearity correction table (luxcorrection.cpp)
+//          against the reference polynomial of the VEML7700 application note, 0 ~ 140 klx
+// build (host):
+//   $ g++ -O2 -std=c++17 -I main/include/peripheral -I main/src/peripheral scripts/lux_correction_test.cpp -o /tmp/lux_correction_test
+// usage: /tmp/lux_correction_test (exit code 0: all passed)
+#include "luxcorrection.cpp"    // table and knot constants are internal to the translation unit
+#include <math.h>
+#include <stdio.h>
+
+#define MAX_RELATIVE_ERROR  0.0015  // documented max interpolation error ~0.14 %
+#define MAX_ABSOLUTE_ERROR  0.01    // unit: lux (near 0, float rounding)
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// independent copy of the application note polynomial (not the one used to build the table)
+static double reference(double x)
+{
+    return 6.0135e-13 * pow(x, 4) - 9.3924e-9 * pow(x, 3) + 8.1488e-5 * pow(x, 2) + 1.0023 * x;
+}
+
+static bool within_tolerance(double value, double expected)
+{
+    return fabs(value - expected) <= MAX_ABSOLUTE_ERROR + MAX_RELATIVE_ERROR * fabs(expected);
+}
+
+static void test_knots()
+{
+    // every knot lies on the polynomial (float rounding only)
+    for (size_t i = 0; i < CORRECTION_KNOT_COUNT; i++) {
+        double expected = reference(correction_table[i].x);
+        CHECK(fabs(correction_table[i].y - expected) <= 1e-6 * expected + 1e-6);
+        CHECK(lux_correction_apply(correction_table[i].x) == correction_table[i].y);
+    }
+    // top knot: first knot at or beyond the linear limit, corrected value covers 140 klx
+    const correction_knot_t &top = correction_table[CORRECTION_KNOT_COUNT - 1];
+    CHECK(top.x >= CORRECTION_LINEAR_MAX);
+    CHECK(correction_table[CORRECTION_KNOT_COUNT - 2].x < CORRECTION_LINEAR_MAX);
+    CHECK(top.y >= 140000.f);
+    printf("knots: %zu, top knot: %.1f -> %.1f lux\n", CORRECTION_KNOT_COUNT, top.x, top.y);
+}
+
+static void test_interpolation()
+{
+    // dense sweep of the linear input covering 0 ~ 140 klx corrected output
+    double max_error = 0.;
+    double max_error_x = 0.;
+    double prev = 0.;
+    const double top_x = correction_table[CORRECTION_KNOT_COUNT - 1].x;
+    for (double x = 0.; x <= top_x; x += (x < 100. ? 0.01 : x * 1e-4)) {
+        double expected = reference(x);
+        double value = lux_correction_apply((float)x);
+        if (!within_tolerance(value, expected)) {
+            printf("FAIL x: %.3f, table: %.3f, polynomial: %.3f\n", x, value, expected);
+            failures++;
+            break;
+        }
+        if (expected > 0.) {
+            double error = fabs(value - expected) / expected;
+            if (error > max_error) {
+                max_error = error;
+                max_error_x = x;
+            }
+        }
+        // monotonic (no step at segment boundaries)
+        CHECK(value >= prev);
+        prev = value;
+    }
+    printf("max relative error: %.4f %% at %.1f lux (linear)\n", max_error * 100., max_error_x);
+    // 140 klx corrected is inside the table
+    double x_140k = 0.;
+    while (reference(x_140k) < 140000.) {
+        x_140k += 0.5;
+    }
+    CHECK(x_140k <= top_x);
+    CHECK(within_tolerance(lux_correction_apply((float)x_140k), 140000.));
+}
+
+static void test_out_of_range()
+{
+    CHECK(lux_correction_apply(0.f) == 0.f);
+    CHECK(lux_correction_apply(-1.f) == 0.f);
+    CHECK(lux_correction_apply(-1e9f) == 0.f);
+    CHECK(lux_correction_apply(-INFINITY) == 0.f);
+
+    // beyond the top knot: extrapolated with the last segment (continuous, increasing, finite)
+    const correction_knot_t &k0 = correction_table[CORRECTION_KNOT_COUNT - 2];
+    const correction_knot_t &k1 = correction_table[CORRECTION_KNOT_COUNT - 1];
+    double slope = (k1.y - k0.y) / (k1.x - k0.x);
+    const float beyond[] = {k1.x + 1.f, 30000.f, 65535.f * 1.8432f};
+    float prev = k1.y;
+    for (float x : beyond) {
+        float value = lux_correction_apply(x);
+        CHECK(isfinite(value));
+        CHECK(value > prev);
+        CHECK(fabs(value - (k1.y + (x - k1.x) * slope)) <= 1e-4 * value);
+        prev = value;
+    }
+    // just below the top knot uses the last segment too
+    CHECK(within_tolerance(lux_correction_apply(nextafterf(k1.x, 0.f)), reference(nextafterf(k1.x, 0.f))));
+}
+
+static void test_required()
+{
+    CHECK(lux_correction_required(VEML7700_GAIN_1_8, VEML7700_IT_100MS, 1000));
+    CHECK(lux_correction_required(VEML7700_GAIN_1_4, VEML7700_IT_25MS, 1000));
+    CHECK(!lux_correction_required(VEML7700_GAIN_1, VEML7700_IT_100MS, 1000));
+    CHECK(!lux_correction_required(VEML7700_GAIN_2, VEML7700_IT_800MS, 1000));
+    CHECK(!lux_correction_required(VEML7700_GAIN_1_8, VEML7700_IT_100MS, 0));
+}
+
+int main(int argc, char *argv[])
+{
+    test_knots();
+    test_interpolation();
+    test_out_of_range();
+    test_required();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All lux correction tests passed\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+// matter_names_test.cpp
+// purpose: host test of the sorted matter name tables (matternames.cpp) against the previous switch
+//          based lookup (matter_names_baseline.inc): every id maps to the same name, including "?" for
+//          ids unknown to the baseline (globals, cluster aliases, out of range ids)
+// build (host):
+//   $ g++ -O2 -std=c++17 -I scripts/host_stub -I main/include/system scripts/matter_names_test.cpp main/src/system/matternames.cpp -o /tmp/matter_names_test
+// usage: /tmp/matter_names_test (exit code 0: all passed)
+#include "matternames.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "matter_names_baseline.inc"
+
+#define MAX_REPORTED_FAILURES   20
+
+static int failures = 0;
+static int compared = 0;
+static int known = 0;
+
+static void compare(const char *kind, uint32_t cluster_id, uint32_t id, const char *expected, const char *actual)
+{
+    compared++;
+    if (strcmp(expected, "?") != 0)
+        known++;
+    if (strcmp(expected, actual) == 0)
+        return;
+    if (failures++ < MAX_REPORTED_FAILURES) {
+        printf("FAIL %s cluster 0x%08X id 0x%08X: baseline \"%s\", table \"%s\"\n",
+            kind, (unsigned)cluster_id, (unsigned)id, expected, actual);
+    }
+}
+
+static void test_device()
+{
+    for (uint32_t id = 0; id <= 0xFFFF; id++) {
+        compare("device", 0, id, baseline_get_matter_device_name((uint16_t)id), get_matter_device_name((uint16_t)id));
+    }
+}
+
+static void test_cluster()
+{
+    for (uint32_t id = 0; id <= 0xFFFF; id++) {
+        compare("cluster", id, 0, baseline_get_matter_cluster_name(id), get_matter_cluster_name(id));
+    }
+    // manufacturer specific ids and out of range (> 16 bit) ids
+    const uint32_t extra[] = {0xFFF2FC00, 0xFFF2FC01, 0xFFF2FC02, 0x00010006, 0xFFFFFFFF};
+    for (uint32_t id : extra) {
+        compare("cluster", id, 0, baseline_get_matter_cluster_name(id), get_matter_cluster_name(id));
+    }
+}
+
+static void test_attribute()
+{
+    // standard clusters x (spec range, manufacturer prefix, global attributes)
+    for (uint32_t cluster_id = 0; cluster_id <= 0x0FFF; cluster_id++) {
+        for (uint32_t id = 0; id <= 0x01FF; id++) {
+            compare("attribute", cluster_id, id, baseline_get_matter_attribute_name(cluster_id, id), get_matter_attribute_name(cluster_id, id));
+        }
+        for (uint32_t id = 0xFFF0; id <= 0xFFFF; id++) {
+            compare("attribute", cluster_id, id, baseline_get_matter_attribute_name(cluster_id, id), get_matter_attribute_name(cluster_id, id));
+        }
+        compare("attribute", cluster_id, 0x00010000, baseline_get_matter_attribute_name(cluster_id, 0x00010000), get_matter_attribute_name(cluster_id, 0x00010000));
+    }
+    // manufacturer specific / out of range cluster ids
+    const uint32_t clusters[] = {0xFFF2FC00, 0xFFF2FC01, 0xFFF2FC02, 0x00010402, 0xFFFFFFFF};
+    for (uint32_t cluster_id : clusters) {
+        for (uint32_t id = 0; id <= 0xFFFF; id++) {
+            compare("attribute", cluster_id, id, baseline_get_matter_attribute_name(cluster_id, id), get_matter_attribute_name(cluster_id, id));
+        }
+    }
+}
+
+static void test_command()
+{
+    for (uint32_t cluster_id = 0; cluster_id <= 0x0FFF; cluster_id++) {
+        for (uint32_t id = 0; id <= 0xFF; id++) {
+            compare("command", cluster_id, id, baseline_get_matter_command_name(cluster_id, id), get_matter_command_name(cluster_id, id));
+        }
+        compare("command", cluster_id, 0x00010000, baseline_get_matter_command_name(cluster_id, 0x00010000), get_matter_command_name(cluster_id, 0x00010000));
+    }
+    const uint32_t clusters[] = {0xFFF2FC00, 0xFFF2FC02, 0x00010006, 0xFFFFFFFF};
+    for (uint32_t cluster_id : clusters) {
+        for (uint32_t id = 0; id <= 0xFF; id++) {
+            compare("command", cluster_id, id, baseline_get_matter_command_name(cluster_id, id), get_matter_command_name(cluster_id, id));
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    test_device();
+    test_cluster();
+    test_attribute();
+    test_command();
+
+    printf("compared: %d ids (%d named by baseline)\n", compared, known);
+    if (failures) {
+        printf("%d mismatch(es)\n", failures);
+        return 1;
+    }
+    printf("All matter name tests passed\n");
+    return 0;
+}
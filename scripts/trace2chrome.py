@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+# trace2chrome.py
+# purpose: convert 'matter trace dump' console output to chrome trace json (chrome://tracing, ui.perfetto.dev)
+# input: serial log containing the block between '# trace begin' and '# trace end'
+#        (lines: timestamp_us,phase,core,task,name,arg)
+# output: json file (one track per task, cpu core in event args)
+import argparse
+import json
+import sys
+
+TIMESTAMP_WRAP = 1 << 32  # device records lower 32 bits of esp_timer
+
+
+def load_events(path):
+    events = []
+    inside = False
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('# trace begin'):
+                events = []  # use the last dump in the log
+                inside = True
+                continue
+            if line.startswith('# trace end'):
+                inside = False
+                continue
+            if not inside or not line:
+                continue
+            fields = line.split(',')
+            if len(fields) != 6:
+                continue
+            ts, phase, core, task, name, arg = fields
+            events.append((int(ts), phase, int(core), task, name, int(arg)))
+    return events
+
+
+def convert(events):
+    trace_events = []
+    tids = {}
+    offset = 0
+    prev_ts = None
+    for ts, phase, core, task, name, arg in events:
+        # events are dumped oldest first, so a decreasing timestamp means wrap-around
+        if prev_ts is not None and ts + offset < prev_ts - TIMESTAMP_WRAP // 2:
+            offset += TIMESTAMP_WRAP
+        ts += offset
+        prev_ts = ts
+        if task not in tids:
+            tids[task] = len(tids) + 1
+            trace_events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': tids[task], 'args': {'name': task}})
+        event = {'name': name, 'ph': phase, 'ts': ts, 'pid': 0, 'tid': tids[task], 'args': {'core': core, 'arg': arg}}
+        if phase == 'i':
+            event['s'] = 't'
+        trace_events.append(event)
+    return {'traceEvents': trace_events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert device trace dump to chrome trace json')
+    parser.add_argument('log', help='serial log file containing trace dump')
+    parser.add_argument('-o', '--output', default='trace.json', help='output json file')
+    args = parser.parse_args()
+
+    events = load_events(args.log)
+    if not events:
+        print('no trace events found', file=sys.stderr)
+        return 1
+
+    with open(args.output, 'w') as f:
+        json.dump(convert(events), f)
+    print('# events: %d -> %s' % (len(events), args.output))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
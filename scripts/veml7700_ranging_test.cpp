@@ -0,0 +1,391 @@
+// veml7700_ranging_test.cpp
+// purpose: host test of the VEML7700 driver auto ranging (CLightSensorDriver::auto_range) against a register model:
+//          a fake CI2CMaster backed by the VEML7700 register array (veml7700reg.h) that converts a simulated
+//          scene illuminance with the configured gain / integration time, pins the output at 0xFFFF and
+//          returns the previous output until a refresh cycle (integration time + power saving wait) completed,
+//          the light source class of the samples (lux factor) is checked for hysteresis and debounce
+// build (host):
+//   $ g++ -O2 -std=gnu++17 -I scripts/host_stub -I main/include -I main/include/system -I main/include/peripheral scripts/veml7700_ranging_test.cpp scripts/host_stub/host_stub.cpp main/src/peripheral/veml7700.cpp main/src/peripheral/spectral.cpp main/src/peripheral/luxcorrection.cpp main/src/system/metrics.cpp -o /tmp/veml7700_ranging_test
+// usage: /tmp/veml7700_ranging_test [-v] (exit code 0: all passed, -v: driver log)
+#include "veml7700.h"
+#include "veml7700reg.h"
+#include "spectral.h"
+#include "luxcorrection.h"
+#include "metrics.h"
+#include "host_stub.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define VEML7700_DEVICE_ID      0xC481  // address option 0xC4, device id code 0x81
+#define RANGE_LOW_COUNT         100     // auto ranging window of the driver (CVeml7700Ctrl::RangeLowCount)
+#define RANGE_HIGH_COUNT        10000   // CVeml7700Ctrl::RangeHighCount
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+/**
+ * @brief VEML7700 register model (16 bit little endian registers, command code = register index)
+ */
+typedef struct veml7700_model {
+    uint16_t regs[8];
+    float scene_lux;            // illuminance on the sensor
+    float white_ratio;          // WHITE / ALS output ratio of the light source
+    int64_t cycle_start_us;     // start of the conversion with the current configuration
+    uint16_t als_output;        // last completed conversion
+    uint16_t white_output;
+    bool fail;                  // every transfer fails (sensor unplugged)
+    uint32_t conf_writes;
+    uint32_t stale_reads;       // output read before the conversion with the current configuration completed
+} veml7700_model_t;
+
+static veml7700_model_t model;
+
+static float model_integration_ms(uint16_t conf)
+{
+    switch (veml7700_als_it_t::get(conf)) {
+    case VEML7700_IT_25MS: return 25.f;
+    case VEML7700_IT_50MS: return 50.f;
+    case VEML7700_IT_200MS: return 200.f;
+    case VEML7700_IT_400MS: return 400.f;
+    case VEML7700_IT_800MS: return 800.f;
+    default: return 100.f;
+    }
+}
+
+static float model_gain(uint16_t conf)
+{
+    const float gain[] = {1.f, 2.f, 0.125f, 0.25f};   // register value order
+    return gain[veml7700_als_gain_t::get(conf)];
+}
+
+// lux per count of the configuration (datasheet: 0.0036 lux/count at gain 2, 800ms)
+static float model_resolution(uint16_t conf)
+{
+    return 0.0036f * (800.f / model_integration_ms(conf)) * (2.f / model_gain(conf));
+}
+
+static uint16_t model_count(float value)
+{
+    return (uint16_t)fminf(roundf(value), 65535.f);
+}
+
+static void model_reset(float scene_lux, float white_ratio = 1.25f)
+{
+    memset(&model, 0, sizeof(model));
+    model.regs[veml7700_reg_als_conf_t::code] = veml7700_als_sd_t::encode(1);  // power on default: shut down
+    model.regs[veml7700_reg_id_t::code] = VEML7700_DEVICE_ID;
+    model.scene_lux = scene_lux;
+    model.white_ratio = white_ratio;
+}
+
+static void model_update_output()
+{
+    uint16_t conf = model.regs[veml7700_reg_als_conf_t::code];
+    uint16_t psm = model.regs[veml7700_reg_power_saving_t::code];
+    if (veml7700_als_sd_t::get(conf))
+        return;
+    float refresh_ms = model_integration_ms(conf);
+    if (veml7700_psm_en_t::get(psm)) {
+        const float wait_ms[] = {500.f, 1000.f, 2000.f, 4000.f};
+        refresh_ms += wait_ms[veml7700_psm_t::get(psm)];
+    }
+    if (esp_timer_get_time() - model.cycle_start_us < (int64_t)(refresh_ms * 1000.f)) {
+        model.stale_reads++;
+        return;
+    }
+    float count = model.scene_lux / model_resolution(conf);
+    model.als_output = model_count(count);
+    model.white_output = model_count(count * model.white_ratio);
+}
+
+static void model_write(uint8_t code, uint16_t value)
+{
+    if (code >= sizeof(model.regs) / sizeof(model.regs[0]) || code == veml7700_reg_als_t::code
+        || code == veml7700_reg_white_t::code || code == veml7700_reg_id_t::code)
+        return;
+    if (code == veml7700_reg_als_conf_t::code) {
+        // any write restarts the conversion
+        model.conf_writes++;
+        model.cycle_start_us = esp_timer_get_time();
+    }
+    model.regs[code] = value;
+}
+
+static uint16_t model_read(uint8_t code)
+{
+    if (code == veml7700_reg_als_t::code) {
+        model_update_output();
+        return model.als_output;
+    }
+    if (code == veml7700_reg_white_t::code) {
+        return model.white_output;  // same conversion as the last ALS read
+    }
+    return code < sizeof(model.regs) / sizeof(model.regs[0]) ? model.regs[code] : 0;
+}
+
+/* fake bus master: only the transfers of the VEML7700 driver, forwarded to the register model */
+CI2CMaster::CI2CMaster()
+{
+}
+
+CI2CMaster::~CI2CMaster()
+{
+}
+
+bool CI2CMaster::write_bytes(uint8_t dev_addr, uint8_t *data, size_t data_len, uint32_t timeout_ms/*=I2C_TRANSFER_TIMEOUT_MS*/)
+{
+    if (model.fail || dev_addr != VEML7700_I2CADDR_DEFAULT || data_len != 3)
+        return false;
+    model_write(data[0], (uint16_t)data[1] | ((uint16_t)data[2] << 8));
+    return true;
+}
+
+bool CI2CMaster::write_and_read_bytes(uint8_t dev_addr, uint8_t *data_write, size_t data_write_len, uint8_t *data_read, size_t data_read_len, uint32_t timeout_ms/*=I2C_TRANSFER_TIMEOUT_MS*/)
+{
+    if (model.fail || dev_addr != VEML7700_I2CADDR_DEFAULT || data_write_len != 1 || data_read_len != 2)
+        return false;
+    uint16_t value = model_read(data_write[0]);
+    data_read[0] = (uint8_t)(value & 0xFF);
+    data_read[1] = (uint8_t)(value >> 8);
+    return true;
+}
+
+static CI2CMaster bus;
+
+typedef struct measurement {
+    bool ok;
+    light_sample_t sample;
+    uint32_t steps;
+    uint32_t saturation_recovery;
+    uint32_t clipped;
+    uint32_t failed;
+    int64_t elapsed_us;
+} measurement_t;
+
+static measurement_t measure()
+{
+    measurement_t result;
+    uint32_t steps = GetMetrics()->get_counter(MetricRangingSteps);
+    uint32_t saturation_recovery = GetMetrics()->get_counter(MetricSaturationRecovery);
+    uint32_t clipped = GetMetrics()->get_counter(MetricClippedSamples);
+    uint32_t failed = GetMetrics()->get_counter(MetricSampleFailed);
+    int64_t start_us = esp_timer_get_time();
+    memset(&result.sample, 0, sizeof(result.sample));
+    result.ok = GetVeml7700Ctrl()->read_measurement(&result.sample);
+    result.elapsed_us = esp_timer_get_time() - start_us;
+    result.steps = GetMetrics()->get_counter(MetricRangingSteps) - steps;
+    result.saturation_recovery = GetMetrics()->get_counter(MetricSaturationRecovery) - saturation_recovery;
+    result.clipped = GetMetrics()->get_counter(MetricClippedSamples) - clipped;
+    result.failed = GetMetrics()->get_counter(MetricSampleFailed) - failed;
+    // every measurement releases its power management locks
+    CHECK(host_get_pm_lock_depth() == 0);
+    return result;
+}
+
+// sample taken at the expected configuration with the model output of a completed conversion,
+// lux = output count x resolution (+ non-linearity correction, light source factor)
+static void check_sample(const measurement_t &m, uint8_t gain, uint8_t integ_time, uint32_t steps)
+{
+    CHECK(m.ok);
+    CHECK(m.sample.gain == gain);
+    CHECK(m.sample.integ_time == integ_time);
+    CHECK(m.steps == steps);
+    CHECK(model.stale_reads == 0);
+    uint16_t conf = veml7700_als_gain_t::encode(gain) | veml7700_als_it_t::encode(integ_time);
+    CHECK(m.sample.conversion_ms == (uint16_t)model_integration_ms(conf));
+    CHECK(m.sample.raw == model_count(model.scene_lux / model_resolution(conf)));
+    CHECK(m.sample.raw_aux == model_count(model.scene_lux / model_resolution(conf) * model.white_ratio));
+    float lux = (float)m.sample.raw * model_resolution(conf);
+    if (lux_correction_required(gain, integ_time, m.sample.raw)) {
+        lux = lux_correction_apply(lux);
+    }
+    lux *= get_light_source_lux_factor((eLightSourceClass)m.sample.source_class);
+    CHECK(fabsf(m.sample.lux - lux) <= 1e-4f * lux);
+}
+
+static void test_initialize()
+{
+    model_reset(100.f);
+    CHECK(GetVeml7700Ctrl()->initialize(&bus));
+    uint16_t conf = model.regs[veml7700_reg_als_conf_t::code];
+    CHECK(veml7700_als_sd_t::get(conf) == 0);
+    CHECK(veml7700_als_int_en_t::get(conf) == 0);
+    CHECK(veml7700_psm_en_t::get(model.regs[veml7700_reg_power_saving_t::code]) == 0);
+    CHECK(GetVeml7700Ctrl()->set_ranging_policy(RangingAuto, VEML7700_GAIN_1_8, VEML7700_IT_100MS));
+}
+
+static void test_in_window()
+{
+    // 100 lux at the start configuration (gain 1/8, 100ms): 217 counts, no ranging
+    model_reset(100.f);
+    CHECK(GetVeml7700Ctrl()->initialize(&bus));
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_100MS, 0);
+    CHECK(m.sample.raw > RANGE_LOW_COUNT && m.sample.raw <= RANGE_HIGH_COUNT);
+    CHECK(!m.sample.clipped);
+}
+
+static void test_range_up()
+{
+    // 1 lux: gain 1/8 -> 1/4 -> 1 -> 2 first, then integration time 100 -> 200 -> 400ms (138 counts)
+    model_reset(1.f);
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_2, VEML7700_IT_400MS, 5);
+    CHECK(m.sample.raw > RANGE_LOW_COUNT);
+    CHECK(m.saturation_recovery == 0);
+    CHECK(fabsf(m.sample.lux - 1.f) <= 0.05f);
+
+    // dark: most sensitive configuration is the end of the table
+    model_reset(0.f);
+    m = measure();
+    check_sample(m, VEML7700_GAIN_2, VEML7700_IT_800MS, 6);
+    CHECK(m.sample.raw == 0);
+    CHECK(m.sample.lux == 0.f);
+}
+
+static void test_range_down()
+{
+    // 5000 lux: 10851 counts at 100ms -> 50ms (5425 counts), gain unchanged
+    model_reset(5000.f);
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_50MS, 1);
+    CHECK(m.sample.raw <= RANGE_HIGH_COUNT);
+    CHECK(m.saturation_recovery == 0);
+
+    // 15000 lux: 100 -> 50 -> 25ms
+    model_reset(15000.f);
+    m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_25MS, 2);
+}
+
+static void test_saturation()
+{
+    // 80 klx pins the output at the start configuration: single jump to the least sensitive one
+    model_reset(80000.f);
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_25MS, 1);
+    CHECK(m.saturation_recovery == 1);
+    CHECK(m.clipped == 0);
+    CHECK(!m.sample.clipped);
+    // high output count at the least sensitive configuration is corrected (non-linearity)
+    CHECK(m.sample.lux > 80000.f);
+
+    // WHITE channel pins first under broadband light (ALS 65104 counts is still below the pinned level)
+    model_reset(30000.f, 4.f);
+    m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_25MS, 1);
+    CHECK(m.saturation_recovery == 1);
+
+    // beyond the range: pinned at the least sensitive configuration, annotated as clipped
+    model_reset(200000.f);
+    m = measure();
+    CHECK(m.ok);
+    CHECK(m.sample.gain == VEML7700_GAIN_1_8 && m.sample.integ_time == VEML7700_IT_25MS);
+    CHECK(m.sample.raw == 0xFFFF);
+    CHECK(m.saturation_recovery == 1);
+    CHECK(m.clipped == 1);
+    CHECK(m.sample.clipped);
+    CHECK(model.stale_reads == 0);
+}
+
+static void test_power_saving()
+{
+    // every read waits for a whole refresh cycle (integration time + power saving wait)
+    model_reset(1.f);
+    CHECK(GetVeml7700Ctrl()->set_power_saving(true, VEML7700_POWERSAVE_MODE2));
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_2, VEML7700_IT_400MS, 5);
+    CHECK(m.elapsed_us >= 6 * (int64_t)1000000);    // 6 conversions of at least 1s wait each
+    CHECK(GetVeml7700Ctrl()->set_power_saving(false));
+}
+
+static void test_fixed()
+{
+    model_reset(100.f);
+    CHECK(GetVeml7700Ctrl()->set_ranging_policy(RangingFixed, VEML7700_GAIN_1, VEML7700_IT_200MS));
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_1, VEML7700_IT_200MS, 0);
+
+    // no ranging and no saturation recovery, pinned output is annotated only
+    model_reset(100000.f);
+    m = measure();
+    CHECK(m.ok);
+    CHECK(m.sample.gain == VEML7700_GAIN_1 && m.sample.integ_time == VEML7700_IT_200MS);
+    CHECK(m.steps == 0 && m.saturation_recovery == 0);
+    CHECK(m.sample.clipped);
+    CHECK(GetVeml7700Ctrl()->set_ranging_policy(RangingAuto, VEML7700_GAIN_1_8, VEML7700_IT_100MS));
+}
+
+static void test_bus_failure()
+{
+    model_reset(100.f);
+    model.fail = true;
+    measurement_t m = measure();
+    CHECK(!m.ok);
+    CHECK(m.failed == 1);
+    model.fail = false;
+    m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_100MS, 0);
+}
+
+static eLightSourceClass measure_source(float als_white_ratio)
+{
+    // 100 lux at the start configuration (217 ALS counts), WHITE output from the ALS / WHITE ratio
+    model_reset(100.f, 1.f / als_white_ratio);
+    measurement_t m = measure();
+    check_sample(m, VEML7700_GAIN_1_8, VEML7700_IT_100MS, 0);
+    return (eLightSourceClass)m.sample.source_class;
+}
+
+static void test_light_source()
+{
+    // class (and the lux factor) does not flip around the incandescent / daylight boundary (ratio 0.45)
+    model_reset(100.f);
+    CHECK(GetVeml7700Ctrl()->initialize(&bus));
+    CHECK(measure_source(0.40f) == LightSourceIncandescent);
+    for (int i = 0; i < 4; i++) {
+        CHECK(measure_source(0.46f) == LightSourceIncandescent);
+        CHECK(measure_source(0.44f) == LightSourceIncandescent);
+    }
+    // beyond the hysteresis: new class after LIGHT_SOURCE_DEBOUNCE_COUNT samples, a single outlier is ignored
+    CHECK(measure_source(0.60f) == LightSourceIncandescent);
+    CHECK(measure_source(0.60f) == LightSourceIncandescent);
+    CHECK(measure_source(0.60f) == LightSourceDaylight);
+    CHECK(measure_source(0.40f) == LightSourceDaylight);
+    CHECK(measure_source(0.60f) == LightSourceDaylight);
+    CHECK(measure_source(0.40f) == LightSourceDaylight);
+}
+
+int main(int argc, char *argv[])
+{
+    host_set_log_enabled(argc > 1 && !strcmp(argv[1], "-v"));
+    host_advance_us(1000000);
+
+    test_initialize();
+    test_in_window();
+    test_range_up();
+    test_range_down();
+    test_saturation();
+    test_power_saving();
+    test_fixed();
+    test_bus_failure();
+    test_light_source();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("ranging steps: %u, saturation recovery: %u, clipped: %u, failed: %u\n",
+        GetMetrics()->get_counter(MetricRangingSteps), GetMetrics()->get_counter(MetricSaturationRecovery),
+        GetMetrics()->get_counter(MetricClippedSamples), GetMetrics()->get_counter(MetricSampleFailed));
+    printf("All VEML7700 ranging tests passed\n");
+    return 0;
+}